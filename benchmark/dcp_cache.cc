@@ -0,0 +1,97 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+/** @file  benchmark/dcp_cache.cc
+ *  @brief Compare the time taken to read a DCP with and without a DCPCache.
+ *
+ *  Usage: dcp_cache [<DCP directory>] [<count>]
+ *
+ *  With no DCP, test/ref/DCP/dcp_test1 is read.
+ */
+
+
+#include "dcp.h"
+#include "dcp_cache.h"
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+
+using std::cout;
+using std::function;
+using std::make_shared;
+
+
+int
+main (int argc, char* argv[])
+{
+	boost::filesystem::path const directory = argc > 1 ? argv[1] : "test/ref/DCP/dcp_test1";
+	int const count = argc > 2 ? atoi(argv[2]) : 1000;
+	boost::filesystem::path const cache_directory = "build/benchmark/dcp_cache";
+
+	auto measure = [count](char const* name, function<void ()> read) {
+		auto start = std::chrono::steady_clock::now ();
+		for (int i = 0; i < count; ++i) {
+			read ();
+		}
+		double const time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		cout << name << ": " << time * 1e6 / count << "us per read.\n";
+	};
+
+	measure ("no cache", [directory]() {
+		make_shared<dcp::DCP>(directory)->read ();
+	});
+
+	measure ("miss", [directory, cache_directory]() {
+		boost::filesystem::remove_all (cache_directory);
+		dcp::DCPCache (cache_directory).read (directory);
+	});
+
+	measure ("hit on a snapshot from disk", [directory, cache_directory]() {
+		dcp::DCPCache (cache_directory).read (directory);
+	});
+
+	dcp::DCPCache cache (cache_directory);
+	measure ("hit on a snapshot in memory", [directory, &cache]() {
+		cache.read (directory);
+	});
+
+	if (cache.misses() != 0) {
+		cout << "Snapshot was not used.\n";
+		return EXIT_FAILURE;
+	}
+}
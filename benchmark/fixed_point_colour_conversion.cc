@@ -0,0 +1,166 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  benchmark/fixed_point_colour_conversion.cc
+ *  @brief Compare the speed and accuracy of fixed-point colour conversion against the exact conversion.
+ */
+
+
+#include "colour_conversion.h"
+#include "fixed_point_colour_conversion.h"
+#include "openjpeg_image.h"
+#include "rgb_xyz.h"
+#include <boost/scoped_array.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+
+
+using std::cout;
+using std::max;
+using std::shared_ptr;
+using boost::scoped_array;
+
+
+int const trials = 16;
+
+
+class Error
+{
+public:
+	void add (int a, int b) {
+		int const e = std::abs (a - b);
+		_max = max (_max, e);
+		_total += e;
+		++_count;
+	}
+
+	int max_error () const {
+		return _max;
+	}
+
+	double mean_error () const {
+		return _count ? static_cast<double>(_total) / _count : 0;
+	}
+
+private:
+	int _max = 0;
+	int64_t _total = 0;
+	int64_t _count = 0;
+};
+
+
+template <class F>
+double
+seconds_per_frame (F f)
+{
+	auto start = std::chrono::steady_clock::now ();
+	for (int i = 0; i < trials; ++i) {
+		f ();
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / trials;
+}
+
+
+static void
+report (char const * name, dcp::ColourConversion const & conversion, dcp::Size size, uint8_t const * rgb)
+{
+	dcp::FixedPointColourConversion fixed (conversion);
+
+	shared_ptr<dcp::OpenJPEGImage> exact_xyz;
+	shared_ptr<dcp::OpenJPEGImage> fixed_xyz;
+	double const exact_to_xyz = seconds_per_frame ([&]() { exact_xyz = dcp::rgb_to_xyz(rgb, size, size.width * 6, conversion); });
+	double const fixed_to_xyz = seconds_per_frame ([&]() { fixed_xyz = dcp::rgb_to_xyz(rgb, size, size.width * 6, fixed); });
+
+	Error to_xyz_error;
+	for (int c = 0; c < 3; ++c) {
+		for (int i = 0; i < size.width * size.height; ++i) {
+			to_xyz_error.add (exact_xyz->data(c)[i], fixed_xyz->data(c)[i]);
+		}
+	}
+
+	scoped_array<uint8_t> exact_rgb (new uint8_t[size.width * size.height * 6]);
+	scoped_array<uint8_t> fixed_rgb (new uint8_t[size.width * size.height * 6]);
+	double const exact_to_rgb = seconds_per_frame ([&]() { dcp::xyz_to_rgb(exact_xyz, conversion, exact_rgb.get(), size.width * 6); });
+	double const fixed_to_rgb = seconds_per_frame ([&]() { dcp::xyz_to_rgb(exact_xyz, fixed, fixed_rgb.get(), size.width * 6); });
+
+	Error to_rgb_error;
+	auto e = reinterpret_cast<uint16_t const *>(exact_rgb.get());
+	auto f = reinterpret_cast<uint16_t const *>(fixed_rgb.get());
+	for (int i = 0; i < size.width * size.height * 3; ++i) {
+		to_rgb_error.add (e[i], f[i]);
+	}
+
+	scoped_array<uint8_t> exact_rgba (new uint8_t[size.width * size.height * 4]);
+	scoped_array<uint8_t> fixed_rgba (new uint8_t[size.width * size.height * 4]);
+	double const exact_to_rgba = seconds_per_frame ([&]() { dcp::xyz_to_rgba(exact_xyz, conversion, exact_rgba.get(), size.width * 4); });
+	double const fixed_to_rgba = seconds_per_frame ([&]() { dcp::xyz_to_rgba(exact_xyz, fixed, fixed_rgba.get(), size.width * 4); });
+
+	Error to_rgba_error;
+	for (int i = 0; i < size.width * size.height * 4; ++i) {
+		to_rgba_error.add (exact_rgba[i], fixed_rgba[i]);
+	}
+
+	cout << name << "\n";
+	cout << "  RGB to XYZ:  exact " << 1 / exact_to_xyz << " fps, fixed-point " << 1 / fixed_to_xyz << " fps; "
+	     << "12-bit error max " << to_xyz_error.max_error() << ", mean " << to_xyz_error.mean_error() << "\n";
+	cout << "  XYZ to RGB:  exact " << 1 / exact_to_rgb << " fps, fixed-point " << 1 / fixed_to_rgb << " fps; "
+	     << "16-bit error max " << to_rgb_error.max_error() << ", mean " << to_rgb_error.mean_error() << "\n";
+	cout << "  XYZ to RGBA: exact " << 1 / exact_to_rgba << " fps, fixed-point " << 1 / fixed_to_rgba << " fps; "
+	     << "8-bit error max " << to_rgba_error.max_error() << ", mean " << to_rgba_error.mean_error() << "\n";
+}
+
+
+/** Report speed and accuracy of FixedPointColourConversion against the exact conversions, for 4K frames */
+int
+main ()
+{
+	srand (1);
+
+	dcp::Size size(4096, 2160);
+
+	scoped_array<uint8_t> rgb (new uint8_t[size.width * size.height * 6]);
+	auto p = reinterpret_cast<uint16_t*> (rgb.get());
+	for (int i = 0; i < size.width * size.height * 3; ++i) {
+		*p++ = (rand() & 0xfff) << 4;
+	}
+
+	report ("sRGB", dcp::ColourConversion::srgb_to_xyz(), size, rgb.get());
+	report ("Rec. 709", dcp::ColourConversion::rec709_to_xyz(), size, rgb.get());
+	report ("P3", dcp::ColourConversion::p3_to_xyz(), size, rgb.get());
+	report ("Rec. 2020", dcp::ColourConversion::rec2020_to_xyz(), size, rgb.get());
+	report ("S-Gamut3", dcp::ColourConversion::s_gamut3_to_xyz(), size, rgb.get());
+}
@@ -40,6 +40,7 @@
 #include <sys/time.h>
 #include <iostream>
 #include <cstdio>
+#include <cstdlib>
 
 using std::cout;
 using std::cerr;
@@ -81,12 +82,16 @@ int
 main (int argc, char* argv[])
 {
 	if (argc < 2) {
-		cerr << "Syntax: " << argv[0] << " private-test-path\n";
+		cerr << "Syntax: " << argv[0] << " private-test-path [threads]\n";
 		exit (EXIT_FAILURE);
 	}
 
 	int const count = 100;
 	int const j2k_bandwidth = 100000000;
+	int const threads = argc > 2 ? atoi(argv[2]) : 1;
+
+	dcp::J2KDecoder decoder (0, threads);
+	dcp::J2KEncoder encoder (j2k_bandwidth, 24, false, false, "libdcp", threads);
 
 	dcp::ArrayData j2k (boost::filesystem::path (argv[1]) / "thx.j2c");
 
@@ -96,10 +101,12 @@ main (int argc, char* argv[])
 	dcp::ArrayData recomp;
 	for (int i = 0; i < count; ++i) {
 		decompress.start ();
-		shared_ptr<dcp::OpenJPEGImage> xyz = dcp::decompress_j2k (j2k, 0);
+		shared_ptr<dcp::OpenJPEGImage> xyz = decoder.decode (j2k);
 		decompress.stop ();
+		/* Let go of the last frame so that the encoder can re-use its buffer */
+		recomp = dcp::ArrayData ();
 		compress.start ();
-		recomp = dcp::compress_j2k (xyz, j2k_bandwidth, 24, false, false);
+		recomp = encoder.encode (xyz);
 		compress.stop ();
 		cout << (i + 1) << " ";
 		cout.flush ();
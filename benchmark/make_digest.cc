@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  benchmark/make_digest.cc
+ *  @brief Compare the throughput of the different ways that make_digest() can read a file.
+ *
+ *  Usage: make_digest [<file>] [<block size in MB>]
+ *
+ *  With no file a 1GB file of random data is made.  Everything apart from DigestIO::DIRECT
+ *  may read the file from the OS cache, so for a fair comparison on a big file drop the
+ *  cache (e.g. echo 3 > /proc/sys/vm/drop_caches) between runs, or use a file bigger than RAM.
+ */
+
+
+#include "util.h"
+#include <boost/filesystem.hpp>
+#include <boost/scoped_array.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdint.h>
+
+
+using std::cout;
+using std::string;
+using boost::scoped_array;
+
+
+int
+main (int argc, char* argv[])
+{
+	boost::filesystem::path file = "build/benchmark/make_digest.data";
+	if (argc > 1) {
+		file = argv[1];
+	} else if (!boost::filesystem::exists(file)) {
+		srand (1);
+		int const block = 1024 * 1024;
+		scoped_array<uint8_t> data (new uint8_t[block]);
+		auto f = fopen (file.string().c_str(), "wb");
+		if (!f) {
+			cout << "Could not create " << file.string() << "\n";
+			return EXIT_FAILURE;
+		}
+		for (int i = 0; i < 1024; ++i) {
+			for (int j = 0; j < block; ++j) {
+				data[j] = rand() & 0xff;
+			}
+			fwrite (data.get(), 1, block, f);
+		}
+		fclose (f);
+	}
+
+	int const block_size = (argc > 2 ? atoi(argv[2]) : 8) * 1024 * 1024;
+	double const megabytes = boost::filesystem::file_size(file) / (1024.0 * 1024);
+
+	char const * names[] = { "standard", "stream", "direct", "mmap" };
+
+	string reference;
+	for (auto io: { dcp::DigestIO::STANDARD, dcp::DigestIO::STREAM, dcp::DigestIO::DIRECT, dcp::DigestIO::MMAP }) {
+		auto start = std::chrono::steady_clock::now ();
+		auto const digest = dcp::make_digest (file, {}, io, block_size);
+		double const time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (reference.empty()) {
+			reference = digest;
+		}
+		cout << names[static_cast<int>(io)] << ": " << megabytes / time << " MB/s"
+		     << (digest == reference ? "" : " (DIGEST DIFFERS FROM STANDARD)") << ".\n";
+	}
+}
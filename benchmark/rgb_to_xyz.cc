@@ -35,13 +35,29 @@
 #include "rgb_xyz.h"
 #include "colour_conversion.h"
 #include <boost/scoped_array.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <stdint.h>
 
 using boost::scoped_array;
+using std::cout;
 using std::shared_ptr;
 
 int const trials = 256;
 
+
+static double
+run (uint8_t const * rgb, dcp::Size size, dcp::RGBToXYZKernel kernel, shared_ptr<dcp::OpenJPEGImage>& xyz)
+{
+	auto start = std::chrono::steady_clock::now ();
+	for (int i = 0; i < trials; ++i) {
+		xyz = dcp::rgb_to_xyz (rgb, size, size.width * 6, dcp::ColourConversion::srgb_to_xyz(), kernel);
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
 int
 main ()
 {
@@ -60,10 +76,23 @@ main ()
 		}
 	}
 
-	shared_ptr<dcp::OpenJPEGImage> xyz;
-	for (int i = 0; i < trials; ++i) {
-		xyz = dcp::rgb_to_xyz (rgb.get(), size, size.width * 6, dcp::ColourConversion::srgb_to_xyz());
-	}
-}
+	char const * names[] = { "scalar", "SSE2", "AVX2" };
 
+	shared_ptr<dcp::OpenJPEGImage> reference;
+	double const scalar = run (rgb.get(), size, dcp::RGBToXYZKernel::SCALAR, reference);
+	cout << "scalar: " << trials / scalar << " fps.\n";
 
+	for (auto kernel: { dcp::RGBToXYZKernel::SSE2, dcp::RGBToXYZKernel::AVX2 }) {
+		if (kernel > dcp::best_rgb_to_xyz_kernel()) {
+			continue;
+		}
+		shared_ptr<dcp::OpenJPEGImage> xyz;
+		double const time = run (rgb.get(), size, kernel, xyz);
+		bool same = true;
+		for (int c = 0; c < 3; ++c) {
+			same = same && std::equal (xyz->data(c), xyz->data(c) + size.width * size.height, reference->data(c));
+		}
+		cout << names[static_cast<int>(kernel)] << ": " << trials / time << " fps, speedup " << scalar / time << "x"
+		     << (same ? "" : " (OUTPUT DIFFERS FROM SCALAR)") << ".\n";
+	}
+}
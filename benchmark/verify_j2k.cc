@@ -0,0 +1,91 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  benchmark/verify_j2k.cc
+ *  @brief Measure how many frames per second verify_j2k() can check.
+ *
+ *  Usage: verify_j2k [<j2c file>] [<count>]
+ *
+ *  With no file, a 2K frame of noise is encoded and checked.
+ */
+
+
+#include "array_data.h"
+#include "j2k_transcode.h"
+#include "openjpeg_image.h"
+#include "verify.h"
+#include "verify_j2k.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+
+using std::cout;
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+
+
+int
+main (int argc, char* argv[])
+{
+	shared_ptr<dcp::ArrayData> frame;
+	if (argc > 1) {
+		frame = make_shared<dcp::ArrayData>(boost::filesystem::path(argv[1]));
+	} else {
+		srand (1);
+		auto xyz = make_shared<dcp::OpenJPEGImage>(dcp::Size(1998, 1080));
+		for (int c = 0; c < 3; ++c) {
+			for (int p = 0; p < (1998 * 1080); ++p) {
+				xyz->data(c)[p] = rand() & 0xfff;
+			}
+		}
+		frame = make_shared<dcp::ArrayData>(dcp::compress_j2k(xyz, 250000000, 24, false, false));
+	}
+
+	int const count = argc > 2 ? atoi(argv[2]) : 10000;
+
+	vector<dcp::VerificationNote> notes;
+	auto start = std::chrono::steady_clock::now ();
+	for (int i = 0; i < count; ++i) {
+		notes.clear ();
+		dcp::verify_j2k (frame, notes);
+	}
+	double const time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	cout << count / time << " frames per second (" << frame->size() << " bytes per frame, " << notes.size() << " notes).\n";
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/asset_index.h
+ *  @brief AssetIndex class.
+ */
+
+
+#ifndef LIBDCP_ASSET_INDEX_H
+#define LIBDCP_ASSET_INDEX_H
+
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace dcp {
+
+
+class Asset;
+class FontAsset;
+class LazyAsset;
+
+
+/** @class AssetIndex
+ *  @brief Some assets, which can be found by ID without searching through all of them.
+ *
+ *  IDs are matched in the same way as ids_equal() does, so case and surrounding
+ *  whitespace do not matter.  If more than one asset has the same ID, find()
+ *  returns the one that was added first.
+ *
+ *  An index can also hold LazyAssets, which are kept apart from the other
+ *  assets so that looking them up does not make them.
+ */
+class AssetIndex
+{
+public:
+	AssetIndex () {}
+	explicit AssetIndex (std::vector<std::shared_ptr<Asset>> const& assets);
+
+	void add (std::shared_ptr<Asset> asset);
+	void add (std::vector<std::shared_ptr<Asset>> const& assets);
+	void add (std::shared_ptr<LazyAsset> asset);
+
+	/** @return Asset with the given ID, or nullptr if there is none */
+	std::shared_ptr<Asset> find (std::string id) const;
+
+	/** @return LazyAsset with the given ID, or nullptr if there is none */
+	std::shared_ptr<LazyAsset> find_lazy (std::string id) const;
+
+	/** @return The first FontAsset added whose file has the given leaf name, or nullptr if there is none */
+	std::shared_ptr<FontAsset> find_font (std::string leaf) const;
+
+	/** @return All assets apart from LazyAssets, in the order that they were added */
+	std::vector<std::shared_ptr<Asset>> const& assets () const {
+		return _assets;
+	}
+
+private:
+	std::vector<std::shared_ptr<Asset>> _assets;
+	/** _assets keyed by normalised ID */
+	std::unordered_map<std::string, std::shared_ptr<Asset>> _by_id;
+	/** LazyAssets keyed by normalised ID */
+	std::unordered_map<std::string, std::shared_ptr<LazyAsset>> _lazy_by_id;
+	/** FontAssets with files, keyed by the files' leaf names; Interop subtitles refer to their fonts this way */
+	std::unordered_map<std::string, std::shared_ptr<FontAsset>> _fonts_by_leaf;
+};
+
+
+}
+
+
+#endif
@@ -42,9 +42,15 @@
 
 
 #include "asset.h"
+#include "compose.hpp"
 #include "crypto_context.h"
 #include "dcp_assert.h"
+#include "exceptions.h"
+#include "frame_buffer_pool.h"
+#include "frame_prefetcher.h"
+#include "types.h"
 #include <asdcp/AS_DCP.h>
+#include <functional>
 #include <memory>
 
 
@@ -52,6 +58,7 @@ namespace dcp {
 
 
 class AtmosAsset;
+class MappedEssence;
 class MonoPictureAsset;
 class SoundAsset;
 class StereoPictureAsset;
@@ -61,18 +68,82 @@ template <class R, class F>
 class AssetReader
 {
 public:
+	/** Type of the frames that this reader returns */
+	typedef F Frame;
+
 	AssetReader (AssetReader const&) = delete;
 	AssetReader& operator== (AssetReader const&) = delete;
 
 	~AssetReader ()
 	{
+		/* Stop the prefetcher before it can read any more */
+		_prefetcher.reset ();
 		delete _reader;
 	}
 
+	/** @return The frame at index n.  Its data is held in a buffer which this reader will
+	 *  re-use once the frame has been destroyed.
+	 */
 	std::shared_ptr<const F> get_frame (int n) const
 	{
-		/* Can't use make_shared here as the constructor is private */
-		return std::shared_ptr<const F> (new F(_reader, n, _crypto_context, _check_hmac));
+		if (_prefetcher) {
+			return _prefetcher->get (n);
+		}
+
+		return read_frame (n);
+	}
+
+	/** Start or stop reading (and decrypting) frames on a background thread, ahead of the last
+	 *  frame asked for with get_frame().  This means that a caller which asks for frames in order
+	 *  can work on one frame while the next ones are being read.  Asking for frames out of order
+	 *  still works, but each time it happens the frames that have been read ahead are thrown away.
+	 *
+	 *  While prefetching is on, get_frame() is the only method of this reader which may be used.
+	 *
+	 *  @param depth Number of frames to read ahead, or 0 to stop prefetching.
+	 */
+	void set_prefetch (int depth)
+	{
+		DCP_ASSERT (depth >= 0);
+		_prefetcher.reset ();
+		if (depth > 0) {
+			_prefetcher.reset (new FramePrefetcher<F>([this](int n) { return read_frame(n); }, depth, _frames));
+		}
+	}
+
+	/** Read the frame at index n straight into memory owned by the caller, without
+	 *  making a Frame.  This is for 2D picture, sound and Atmos assets; use the version
+	 *  which takes an Eye for 3D picture assets.
+	 *  @param n Frame index.
+	 *  @param data Memory to read the frame's (decrypted) data into.
+	 *  @param capacity Size of the memory at @p data in bytes; a ReadError is thrown if the frame
+	 *  does not fit.
+	 *  @return Size of the frame in bytes.
+	 */
+	int read_frame_into (int n, uint8_t* data, int capacity) const
+	{
+		typename F::Buffer buffer;
+		buffer.SetData (data, capacity);
+		check_read (_reader->ReadFrame(n, buffer, _crypto_context->context(), _check_hmac ? _crypto_context->hmac() : nullptr), n, capacity);
+		return buffer.Size ();
+	}
+
+	/** Read one eye of the frame at index n of a 3D picture asset straight into memory
+	 *  owned by the caller, without making a Frame.
+	 *  @param n Frame index.
+	 *  @param eye Eye to read.
+	 *  @param data Memory to read the eye's (decrypted) data into.
+	 *  @param capacity Size of the memory at @p data in bytes; a ReadError is thrown if the data
+	 *  does not fit.
+	 *  @return Size of the eye's data in bytes.
+	 */
+	int read_frame_into (int n, Eye eye, uint8_t* data, int capacity) const
+	{
+		ASDCP::JP2K::FrameBuffer buffer;
+		buffer.SetData (data, capacity);
+		auto const phase = eye == Eye::LEFT ? ASDCP::JP2K::SP_LEFT : ASDCP::JP2K::SP_RIGHT;
+		check_read (_reader->ReadFrame(n, phase, buffer, _crypto_context->context(), _check_hmac ? _crypto_context->hmac() : nullptr), n, capacity);
+		return buffer.Size ();
 	}
 
 	R* reader () const {
@@ -83,6 +154,14 @@ public:
 		_check_hmac = check;
 	}
 
+	/** @return true if get_frame() returns frames which point straight into a memory-mapped
+	 *  copy of the MXF, rather than frames which have been read into buffers.
+	 *  See MonoPictureAsset::start_read().
+	 */
+	bool mapped () const {
+		return static_cast<bool>(_map_frame);
+	}
+
 protected:
 	R* _reader = nullptr;
 	std::shared_ptr<DecryptionContext> _crypto_context;
@@ -93,8 +172,10 @@ private:
 	friend class SoundAsset;
 	friend class StereoPictureAsset;
 
-	explicit AssetReader (Asset const * asset, boost::optional<Key> key, Standard standard)
+	/** @param frames Number of frames in the asset */
+	AssetReader (Asset const * asset, boost::optional<Key> key, Standard standard, int64_t frames)
 		: _crypto_context (new DecryptionContext(key, standard))
+		, _frames (frames)
 	{
 		_reader = new R ();
 		DCP_ASSERT (asset->file());
@@ -105,7 +186,42 @@ private:
 		}
 	}
 
+	/** Make get_frame() return frames which point into some mapped essence, rather than
+	 *  reading them with asdcplib.  This is only instantiated for frames which can be made
+	 *  from a MappedEssence.
+	 */
+	void map (std::shared_ptr<const MappedEssence> essence)
+	{
+		_map_frame = [essence](int n) {
+			return std::shared_ptr<const F> (new F(essence, n));
+		};
+	}
+
+	std::shared_ptr<const F> read_frame (int n) const
+	{
+		if (_map_frame) {
+			return _map_frame (n);
+		}
+
+		/* Can't use make_shared here as the constructor is private */
+		return std::shared_ptr<const F> (new F(_reader, n, _crypto_context, _check_hmac, _pool));
+	}
+
+	void check_read (ASDCP::Result_t r, int n, int capacity) const
+	{
+		if (r == Kumu::RESULT_SMALLBUF) {
+			boost::throw_exception (ReadError(String::compose("frame %1 does not fit in %2 bytes", n, capacity)));
+		} else if (ASDCP_FAILURE(r)) {
+			boost::throw_exception (ReadError(String::compose("could not read frame %1 (%2)", n, static_cast<int>(r))));
+		}
+	}
+
+	int64_t _frames;
 	bool _check_hmac = true;
+	std::shared_ptr<FrameBufferPool<typename F::Buffer>> _pool = std::make_shared<FrameBufferPool<typename F::Buffer>>(F::initial_buffer_capacity);
+	std::unique_ptr<FramePrefetcher<F>> _prefetcher;
+	/** function to make frames from mapped essence, if we are using it */
+	std::function<std::shared_ptr<const F> (int)> _map_frame;
 };
 
 
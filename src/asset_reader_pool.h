@@ -0,0 +1,182 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/asset_reader_pool.h
+ *  @brief AssetReaderPool class.
+ */
+
+
+#ifndef LIBDCP_ASSET_READER_POOL_H
+#define LIBDCP_ASSET_READER_POOL_H
+
+
+#include "dcp_assert.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace dcp {
+
+
+/** @class AssetReaderPool
+ *  @brief A set of readers for one asset, so that its frames can be read from many threads at once.
+ *
+ *  An AssetReader can only read one frame at a time, as it has one asdcplib reader and one decryption
+ *  context.  This pool hands out readers so that each thread has one to itself while it reads.  Readers
+ *  are opened when they are first needed and kept for re-use, so N threads reading from the pool open
+ *  the MXF at most N times, however many frames they read.
+ *
+ *  For example:
+ *
+ *  @code
+ *  auto pool = dcp::make_asset_reader_pool(asset);
+ *  // then, on any thread:
+ *  auto frame = pool->get_frame(n);
+ *  @endcode
+ *
+ *  A pool must be owned by a std::shared_ptr, as make_asset_reader_pool() does.
+ */
+template <class Reader>
+class AssetReaderPool : public std::enable_shared_from_this<AssetReaderPool<Reader>>
+{
+public:
+	/** @param open Function to open a new reader; it will be called with no locks held, and may be
+	 *  called from any of the threads that use the pool.
+	 *  @param max_readers Maximum number of readers to open, or 0 for no limit.  Once this many are in
+	 *  use, threads which want to read will wait for one to be returned.
+	 */
+	explicit AssetReaderPool (std::function<std::shared_ptr<Reader> ()> open, int max_readers = 0)
+		: _open (open)
+		, _max_readers (max_readers)
+	{
+		DCP_ASSERT (max_readers >= 0);
+	}
+
+	AssetReaderPool (AssetReaderPool const&) = delete;
+	AssetReaderPool& operator= (AssetReaderPool const&) = delete;
+
+	/** @return A reader which the caller may use until it lets go of it, when it
+	 *  will go back to the pool.  This is useful for a run of calls to a reader's
+	 *  read_frame_into(), for example.
+	 */
+	std::shared_ptr<Reader> reader ()
+	{
+		std::unique_lock<std::mutex> lm (_mutex);
+
+		_free_condition.wait (lm, [this]() {
+			return !_free.empty() || _max_readers == 0 || _opened < _max_readers;
+		});
+
+		std::shared_ptr<Reader> reader;
+		if (!_free.empty()) {
+			reader = _free.back ();
+			_free.pop_back ();
+		} else {
+			++_opened;
+			lm.unlock ();
+			try {
+				reader = _open ();
+			} catch (...) {
+				lm.lock ();
+				--_opened;
+				_free_condition.notify_one ();
+				throw;
+			}
+		}
+
+		/* Give the reader back when the caller has finished with it, as long as the pool is still around */
+		std::weak_ptr<AssetReaderPool> weak = this->shared_from_this ();
+		return std::shared_ptr<Reader> (reader.get(), [weak, reader](Reader *) {
+			if (auto pool = weak.lock()) {
+				pool->put (reader);
+			}
+		});
+	}
+
+	/** @return The frame at index n, read with one of the pool's readers.  This may be
+	 *  called from any thread.
+	 */
+	std::shared_ptr<const typename Reader::Frame> get_frame (int n)
+	{
+		return reader()->get_frame(n);
+	}
+
+	/** @return Number of readers that have been opened */
+	int readers_opened () const {
+		std::lock_guard<std::mutex> lm (_mutex);
+		return _opened;
+	}
+
+private:
+	void put (std::shared_ptr<Reader> reader)
+	{
+		std::lock_guard<std::mutex> lm (_mutex);
+		_free.push_back (reader);
+		_free_condition.notify_one ();
+	}
+
+	std::function<std::shared_ptr<Reader> ()> _open;
+	int const _max_readers;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _free_condition;
+	/** readers which are not in use */
+	std::vector<std::shared_ptr<Reader>> _free;
+	/** number of readers that have been (or are being) opened */
+	int _opened = 0;
+};
+
+
+/** @param asset Asset to read; this is anything with a start_read() method, such as a MonoPictureAsset.
+ *  @param max_readers Maximum number of readers to open, or 0 for no limit.
+ *  @return A pool of readers for the asset.
+ */
+template <class A>
+auto
+make_asset_reader_pool (std::shared_ptr<A> asset, int max_readers = 0)
+	-> std::shared_ptr<AssetReaderPool<typename decltype(asset->start_read())::element_type>>
+{
+	typedef typename decltype(asset->start_read())::element_type Reader;
+	return std::make_shared<AssetReaderPool<Reader>>([asset]() { return asset->start_read(); }, max_readers);
+}
+
+
+}
+
+
+#endif
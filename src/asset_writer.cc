@@ -37,10 +37,12 @@
  */
 
 
+#include "asset.h"
 #include "asset_writer.h"
 #include "crypto_context.h"
 #include "dcp_assert.h"
 #include "mxf.h"
+#include "util.h"
 #include <asdcp/AS_DCP.h>
 #include <asdcp/KM_prng.h>
 
@@ -66,5 +68,13 @@ AssetWriter::finalize ()
 {
 	DCP_ASSERT (!_finalized);
 	_finalized = true;
+
+	if (_started && _hash_on_finalize) {
+		/* All the MXFs that we write are also Assets */
+		auto asset = dynamic_cast<Asset*>(_mxf);
+		DCP_ASSERT (asset);
+		asset->set_hash (make_digest(_file, {}));
+	}
+
 	return _started;
 }
@@ -69,6 +69,15 @@ public:
 	/** @return true if anything was written by this writer */
 	virtual bool finalize ();
 
+	/** @param hash true to calculate the hash of the file in finalize(), once it is complete,
+	 *  and give it to the asset.  This means that Asset::hash() (and so DCP::write_xml()) will
+	 *  not need to read the file again later, and the file is read while as much of it as possible
+	 *  is still in the OS cache.
+	 */
+	void set_hash_on_finalize (bool hash) {
+		_hash_on_finalize = hash;
+	}
+
 	int64_t frames_written () const {
 		return _frames_written;
 	}
@@ -88,6 +97,8 @@ protected:
 	bool _finalized = false;
 	/** true if something has been written to this asset */
 	bool _started = false;
+	/** true to calculate the hash of the file in finalize() */
+	bool _hash_on_finalize = false;
 	std::shared_ptr<EncryptionContext> _crypto_context;
 };
 
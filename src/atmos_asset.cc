@@ -110,7 +110,7 @@ shared_ptr<AtmosAssetReader>
 AtmosAsset::start_read () const
 {
 	/* Can't use make_shared here since the constructor is protected */
-	return shared_ptr<AtmosAssetReader>(new AtmosAssetReader(this, key(), Standard::SMPTE));
+	return shared_ptr<AtmosAssetReader>(new AtmosAssetReader(this, key(), Standard::SMPTE, intrinsic_duration()));
 }
 
 
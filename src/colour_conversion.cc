@@ -54,6 +54,28 @@ using boost::optional;
 using namespace dcp;
 
 
+/* The standard conversions share transfer functions where they can, so that they
+   share the LUTs that the transfer functions make, too.
+*/
+
+static shared_ptr<const TransferFunction>
+shared_gamma (double g)
+{
+	static auto gamma_2_2 = make_shared<GammaTransferFunction>(2.2);
+	static auto gamma_2_4 = make_shared<GammaTransferFunction>(2.4);
+	static auto gamma_2_6 = make_shared<GammaTransferFunction>(2.6);
+
+	if (g == 2.2) {
+		return gamma_2_2;
+	} else if (g == 2.4) {
+		return gamma_2_4;
+	}
+
+	DCP_ASSERT (g == 2.6);
+	return gamma_2_6;
+}
+
+
 ColourConversion const &
 ColourConversion::srgb_to_xyz ()
 {
@@ -65,7 +87,7 @@ ColourConversion::srgb_to_xyz ()
 		Chromaticity (0.15, 0.06),
 		Chromaticity::D65 (),
 		optional<Chromaticity> (),
-		make_shared<GammaTransferFunction>(2.6)
+		shared_gamma(2.6)
 		);
 	return *c;
 }
@@ -74,14 +96,14 @@ ColourConversion const &
 ColourConversion::rec601_to_xyz ()
 {
 	static auto c = new ColourConversion (
-		make_shared<GammaTransferFunction>(2.2),
+		shared_gamma(2.2),
 		YUVToRGB::REC601,
 		Chromaticity (0.64, 0.33),
 		Chromaticity (0.3, 0.6),
 		Chromaticity (0.15, 0.06),
 		Chromaticity::D65 (),
 		optional<Chromaticity> (),
-		make_shared<GammaTransferFunction>(2.6)
+		shared_gamma(2.6)
 		);
 	return *c;
 }
@@ -90,14 +112,14 @@ ColourConversion const &
 ColourConversion::rec709_to_xyz ()
 {
 	static auto c = new ColourConversion (
-		make_shared<GammaTransferFunction>(2.2),
+		shared_gamma(2.2),
 		YUVToRGB::REC709,
 		Chromaticity (0.64, 0.33),
 		Chromaticity (0.3, 0.6),
 		Chromaticity (0.15, 0.06),
 		Chromaticity::D65 (),
 		optional<Chromaticity> (),
-		make_shared<GammaTransferFunction>(2.6)
+		shared_gamma(2.6)
 		);
 	return *c;
 }
@@ -106,14 +128,14 @@ ColourConversion const &
 ColourConversion::p3_to_xyz ()
 {
 	static auto c = new ColourConversion (
-		make_shared<GammaTransferFunction>(2.6),
+		shared_gamma(2.6),
 		YUVToRGB::REC709,
 		Chromaticity (0.68, 0.32),
 		Chromaticity (0.265, 0.69),
 		Chromaticity (0.15, 0.06),
 		Chromaticity (0.314, 0.351),
 		optional<Chromaticity> (),
-		make_shared<GammaTransferFunction>(2.6)
+		shared_gamma(2.6)
 		);
 	return *c;
 }
@@ -125,14 +147,14 @@ ColourConversion::rec1886_to_xyz ()
 	   2.4 gamma, so here goes ...
 	*/
 	static auto c = new ColourConversion (
-		make_shared<GammaTransferFunction>(2.4),
+		shared_gamma(2.4),
 		YUVToRGB::REC709,
 		Chromaticity (0.64, 0.33),
 		Chromaticity (0.3, 0.6),
 		Chromaticity (0.15, 0.06),
 		Chromaticity::D65 (),
 		optional<Chromaticity> (),
-		make_shared<GammaTransferFunction>(2.6)
+		shared_gamma(2.6)
 		);
 	return *c;
 }
@@ -141,14 +163,14 @@ ColourConversion const &
 ColourConversion::rec2020_to_xyz ()
 {
 	static auto c = new ColourConversion (
-		make_shared<GammaTransferFunction>(2.4),
+		shared_gamma(2.4),
 		YUVToRGB::REC709,
 		Chromaticity (0.708, 0.292),
 		Chromaticity (0.170, 0.797),
 		Chromaticity (0.131, 0.046),
 		Chromaticity::D65 (),
 		optional<Chromaticity> (),
-		make_shared<GammaTransferFunction>(2.6)
+		shared_gamma(2.6)
 		);
 	return *c;
 }
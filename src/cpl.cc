@@ -37,6 +37,7 @@
  */
 
 
+#include "asset_index.h"
 #include "certificate_chain.h"
 #include "compose.hpp"
 #include "cpl.h"
@@ -643,6 +644,12 @@ CPL::add (DecryptedKDM const & kdm)
 
 void
 CPL::resolve_refs (vector<shared_ptr<Asset>> assets)
+{
+	resolve_refs (AssetIndex(assets));
+}
+
+void
+CPL::resolve_refs (AssetIndex const& assets)
 {
 	for (auto i: _reels) {
 		i->resolve_refs (assets);
@@ -59,6 +59,7 @@ struct verify_invalid_language3;
 namespace dcp {
 
 
+class AssetIndex;
 class ReelFileAsset;
 class Reel;
 class MXFMetadata;
@@ -120,6 +121,7 @@ public:
 		) const;
 
 	void resolve_refs (std::vector<std::shared_ptr<Asset>>);
+	void resolve_refs (AssetIndex const& assets);
 
 	int64_t duration () const;
 
@@ -38,6 +38,7 @@
 
 
 #include "asset_factory.h"
+#include "asset_index.h"
 #include "atmos_asset.h"
 #include "certificate_chain.h"
 #include "compose.hpp"
@@ -48,7 +49,9 @@
 #include "decrypted_kdm_key.h"
 #include "exceptions.h"
 #include "font_asset.h"
+#include "hash_assets.h"
 #include "interop_subtitle_asset.h"
+#include "lazy_asset.h"
 #include "metadata.h"
 #include "mono_picture_asset.h"
 #include "picture_asset.h"
@@ -69,10 +72,15 @@ LIBDCP_ENABLE_WARNINGS
 #include <xmlsec/app.h>
 LIBDCP_DISABLE_WARNINGS
 #include <libxml++/libxml++.h>
+#include <libxml/xmlreader.h>
 LIBDCP_ENABLE_WARNINGS
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <atomic>
+#include <exception>
 #include <numeric>
+#include <thread>
+#include <unordered_set>
 
 
 using std::string;
@@ -86,6 +94,7 @@ using std::make_shared;
 using std::exception;
 using std::shared_ptr;
 using std::dynamic_pointer_cast;
+using std::unordered_set;
 using boost::optional;
 using boost::algorithm::starts_with;
 using namespace dcp;
@@ -97,6 +106,91 @@ static string const volindex_interop_ns = "http://www.digicine.com/PROTO-ASDCP-V
 static string const volindex_smpte_ns   = "http://www.smpte-ra.org/schemas/429-9/2007/AM";
 
 
+/** @return Name of the root node of an XML file, found by reading only as much of the file as is needed */
+static string
+xml_root_node_name (boost::filesystem::path path)
+{
+	auto reader = xmlReaderForFile (path.string().c_str(), nullptr, 0);
+	if (!reader) {
+		throw ReadError(String::compose("XML error in %1", path.string()), "could not open file");
+	}
+
+	string error;
+	xmlTextReaderSetErrorHandler (
+		reader,
+		[](void* context, char const* message, xmlParserSeverities severity, xmlTextReaderLocatorPtr) {
+			auto error = reinterpret_cast<string*>(context);
+			if (severity == XML_PARSER_SEVERITY_ERROR && error->empty()) {
+				*error = message;
+				boost::algorithm::trim (*error);
+			}
+		},
+		&error
+		);
+
+	optional<string> name;
+	while (!name && xmlTextReaderRead(reader) == 1) {
+		if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
+			name = reinterpret_cast<char const *>(xmlTextReaderConstLocalName(reader));
+		}
+	}
+
+	xmlFreeTextReader (reader);
+
+	if (!name) {
+		throw ReadError(String::compose("XML error in %1", path.string()), error.empty() ? "no root node found" : error);
+	}
+
+	return *name;
+}
+
+
+/** An MXF that DCP::read() opens before it goes through the rest of the DCP */
+struct PendingMXF
+{
+	explicit PendingMXF (boost::filesystem::path path_)
+		: path (path_)
+	{}
+
+	boost::filesystem::path path;
+	shared_ptr<Asset> asset;
+	bool found_threed_marked_as_twod = false;
+	std::exception_ptr error;
+};
+
+
+/** Open some MXFs, with up to threads of them being opened at once */
+static void
+open_mxfs (vector<PendingMXF>& mxfs, bool ignore_incorrect_picture_mxf_type, int threads)
+{
+	std::atomic<size_t> next (0);
+	auto work = [&]() {
+		for (auto i = next++; i < mxfs.size(); i = next++) {
+			try {
+				mxfs[i].asset = asset_factory (mxfs[i].path, ignore_incorrect_picture_mxf_type, &mxfs[i].found_threed_marked_as_twod);
+			} catch (...) {
+				mxfs[i].error = std::current_exception ();
+			}
+		}
+	};
+
+	vector<std::thread> workers;
+	try {
+		for (int i = 1; i < std::min(threads, static_cast<int>(mxfs.size())); ++i) {
+			workers.push_back (std::thread(work));
+		}
+	} catch (...) {
+		/* Carry on with the threads that we have */
+	}
+
+	work ();
+
+	for (auto& i: workers) {
+		i.join ();
+	}
+}
+
+
 DCP::DCP (boost::filesystem::path directory)
 	: _directory (directory)
 {
@@ -109,7 +203,7 @@ DCP::DCP (boost::filesystem::path directory)
 
 
 void
-DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_mxf_type)
+DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_mxf_type, int threads, bool lazy)
 {
 	/* Read the ASSETMAP and PKL */
 
@@ -121,9 +215,19 @@ DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_m
 		boost::throw_exception (MissingAssetmapError(_directory));
 	}
 
+	/* Path to read an ASSETMAP, PKL or CPL from, given its path relative to the DCP;
+	   if we have been given a metadata directory with a copy of the file we use that.
+	*/
+	auto metadata = [this](boost::filesystem::path relative) {
+		if (_metadata_directory && boost::filesystem::exists(*_metadata_directory / relative)) {
+			return *_metadata_directory / relative;
+		}
+		return _directory / relative;
+	};
+
 	cxml::Document asset_map ("AssetMap");
 
-	asset_map.read_file (_asset_map.get());
+	asset_map.read_file (metadata(_asset_map->filename()));
 	if (asset_map.namespace_uri() == assetmap_interop_ns) {
 		_standard = Standard::INTEROP;
 	} else if (asset_map.namespace_uri() == assetmap_smpte_ns) {
@@ -169,7 +273,9 @@ DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_m
 	}
 
 	for (auto i: pkl_paths) {
-		_pkls.push_back (make_shared<PKL>(_directory / i));
+		auto pkl = make_shared<PKL>(metadata(i));
+		pkl->set_file (_directory / i);
+		_pkls.push_back (pkl);
 	}
 
 	/* Now we have:
@@ -183,6 +289,49 @@ DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_m
 	   from the CPLs.
 	*/
 	vector<shared_ptr<Asset>> other_assets;
+	/* Assets to make when they are first needed, if we are being lazy */
+	vector<shared_ptr<LazyAsset>> lazy_assets;
+	/* Assets that lazily-made Interop subtitles can take their fonts from; filled in once we have them all */
+	auto font_assets = make_shared<vector<shared_ptr<Asset>>>();
+
+	/* Find the <Type> for an asset from the PKL that contains it, without any optional parameters (after ;) */
+	auto find_pkl_type = [this](string const& id) -> optional<string> {
+		for (auto j: _pkls) {
+			auto type = j->type(id);
+			if (type) {
+				return optional<string>(type->substr(0, type->find(";")));
+			}
+		}
+		return optional<string>();
+	};
+
+	auto remove_parameters = [](string const& n) {
+		return n.substr(0, n.find(";"));
+	};
+
+	auto is_mxf = [this, remove_parameters](string const& pkl_type) {
+		return
+			pkl_type == remove_parameters(PictureAsset::static_pkl_type(*_standard)) ||
+			pkl_type == remove_parameters(SoundAsset::static_pkl_type(*_standard)) ||
+			pkl_type == remove_parameters(AtmosAsset::static_pkl_type(*_standard)) ||
+			pkl_type == remove_parameters(SMPTESubtitleAsset::static_pkl_type(*_standard));
+	};
+
+	/* If we are using threads, open all the MXFs at once before we go through the assets.  Then the loop
+	   below can take each one as it reaches it, so that any error or note comes in the same place as it
+	   would without threads.
+	*/
+	vector<PendingMXF> opened_mxfs;
+	if (threads > 1 && !lazy) {
+		for (auto i: paths) {
+			auto const pkl_type = find_pkl_type (i.first);
+			if (!i.second.empty() && boost::filesystem::exists(_directory / i.second) && pkl_type && is_mxf(*pkl_type)) {
+				opened_mxfs.push_back (PendingMXF(_directory / i.second));
+			}
+		}
+		open_mxfs (opened_mxfs, ignore_incorrect_picture_mxf_type, threads);
+	}
+	auto next_opened_mxf = opened_mxfs.begin();
 
 	for (auto i: paths) {
 		auto path = _directory / i.second;
@@ -205,15 +354,7 @@ DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_m
 			continue;
 		}
 
-		/* Find the <Type> for this asset from the PKL that contains the asset */
-		optional<string> pkl_type;
-		for (auto j: _pkls) {
-			pkl_type = j->type(i.first);
-			if (pkl_type) {
-				break;
-			}
-		}
-
+		auto const pkl_type = find_pkl_type (i.first);
 		if (!pkl_type) {
 			/* This asset is in the ASSETMAP but not mentioned in any PKL so we don't
 			 * need to worry about it.
@@ -221,50 +362,67 @@ DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_m
 			continue;
 		}
 
-		auto remove_parameters = [](string const& n) {
-			return n.substr(0, n.find(";"));
-		};
-
-		/* Remove any optional parameters (after ;) */
-		pkl_type = pkl_type->substr(0, pkl_type->find(";"));
-
 		if (
 			pkl_type == remove_parameters(CPL::static_pkl_type(*_standard)) ||
 			pkl_type == remove_parameters(InteropSubtitleAsset::static_pkl_type(*_standard))) {
-			auto p = new xmlpp::DomParser;
+			/* Find out what sort of file this is without parsing it all, as it will be parsed by CPL
+			   or InteropSubtitleAsset in a moment.
+			*/
+			auto const source = metadata (i.second);
+			auto const root = xml_root_node_name (source);
+
 			try {
-				p->parse_file (path.string());
-			} catch (std::exception& e) {
-				delete p;
+				if (root == "CompositionPlaylist") {
+					auto cpl = make_shared<CPL>(source);
+					cpl->set_file (path);
+					if (_standard && cpl->standard() != _standard.get() && notes) {
+						notes->push_back ({VerificationNote::Type::ERROR, VerificationNote::Code::MISMATCHED_STANDARD});
+					}
+					_cpls.push_back (cpl);
+				} else if (root == "DCSubtitle") {
+					if (_standard && _standard.get() == Standard::SMPTE && notes) {
+						notes->push_back (VerificationNote(VerificationNote::Type::ERROR, VerificationNote::Code::MISMATCHED_STANDARD));
+					}
+					if (lazy) {
+						lazy_assets.push_back (
+							make_shared<LazyAsset>(i.first, [path, font_assets]() {
+								auto subtitle = make_shared<InteropSubtitleAsset>(path);
+								subtitle->resolve_fonts (*font_assets);
+								return subtitle;
+							})
+						);
+					} else {
+						other_assets.push_back (make_shared<InteropSubtitleAsset>(path));
+					}
+				}
+			} catch (xmlpp::exception& e) {
+				/* Something after the root node is not well-formed */
 				throw ReadError(String::compose("XML error in %1", path.string()), e.what());
 			}
-
-			auto const root = p->get_document()->get_root_node()->get_name();
-			delete p;
-
-			if (root == "CompositionPlaylist") {
-				auto cpl = make_shared<CPL>(path);
-				if (_standard && cpl->standard() != _standard.get() && notes) {
-					notes->push_back ({VerificationNote::Type::ERROR, VerificationNote::Code::MISMATCHED_STANDARD});
+		} else if (is_mxf(*pkl_type)) {
+
+			if (lazy) {
+				lazy_assets.push_back (
+					make_shared<LazyAsset>(i.first, [path, ignore_incorrect_picture_mxf_type]() {
+						return asset_factory (path, ignore_incorrect_picture_mxf_type);
+					})
+				);
+			} else {
+				bool found_threed_marked_as_twod = false;
+				if (next_opened_mxf != opened_mxfs.end()) {
+					DCP_ASSERT (next_opened_mxf->path == path);
+					if (next_opened_mxf->error) {
+						std::rethrow_exception (next_opened_mxf->error);
+					}
+					other_assets.push_back (next_opened_mxf->asset);
+					found_threed_marked_as_twod = next_opened_mxf->found_threed_marked_as_twod;
+					++next_opened_mxf;
+				} else {
+					other_assets.push_back (asset_factory(path, ignore_incorrect_picture_mxf_type, &found_threed_marked_as_twod));
 				}
-				_cpls.push_back (cpl);
-			} else if (root == "DCSubtitle") {
-				if (_standard && _standard.get() == Standard::SMPTE && notes) {
-					notes->push_back (VerificationNote(VerificationNote::Type::ERROR, VerificationNote::Code::MISMATCHED_STANDARD));
+				if (found_threed_marked_as_twod && notes) {
+					notes->push_back ({VerificationNote::Type::WARNING, VerificationNote::Code::THREED_ASSET_MARKED_AS_TWOD, path});
 				}
-				other_assets.push_back (make_shared<InteropSubtitleAsset>(path));
-			}
-		} else if (
-			*pkl_type == remove_parameters(PictureAsset::static_pkl_type(*_standard)) ||
-			*pkl_type == remove_parameters(SoundAsset::static_pkl_type(*_standard)) ||
-			*pkl_type == remove_parameters(AtmosAsset::static_pkl_type(*_standard)) ||
-			*pkl_type == remove_parameters(SMPTESubtitleAsset::static_pkl_type(*_standard))
-			) {
-
-			bool found_threed_marked_as_twod = false;
-			other_assets.push_back (asset_factory(path, ignore_incorrect_picture_mxf_type, &found_threed_marked_as_twod));
-			if (found_threed_marked_as_twod && notes) {
-				notes->push_back ({VerificationNote::Type::WARNING, VerificationNote::Code::THREED_ASSET_MARKED_AS_TWOD, path});
 			}
 		} else if (*pkl_type == remove_parameters(FontAsset::static_pkl_type(*_standard))) {
 			other_assets.push_back (make_shared<FontAsset>(i.first, path));
@@ -275,7 +433,15 @@ DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_m
 		}
 	}
 
-	resolve_refs (other_assets);
+	if (lazy) {
+		*font_assets = other_assets;
+	}
+
+	AssetIndex index (other_assets);
+	for (auto i: lazy_assets) {
+		index.add (i);
+	}
+	resolve_refs (index);
 
 	/* While we've got the ASSETMAP lets look and see if this DCP refers to things that are not in its ASSETMAP */
 	if (notes) {
@@ -292,6 +458,13 @@ DCP::read (vector<dcp::VerificationNote>* notes, bool ignore_incorrect_picture_m
 
 void
 DCP::resolve_refs (vector<shared_ptr<Asset>> assets)
+{
+	resolve_refs (AssetIndex(assets));
+}
+
+
+void
+DCP::resolve_refs (AssetIndex const& assets)
 {
 	for (auto i: cpls()) {
 		i->resolve_refs (assets);
@@ -490,7 +663,8 @@ DCP::write_xml (
 	string issue_date,
 	string annotation_text,
 	shared_ptr<const CertificateChain> signer,
-	NameFormat name_format
+	NameFormat name_format,
+	int hash_threads
 	)
 {
 	if (_cpls.empty()) {
@@ -518,7 +692,12 @@ DCP::write_xml (
 	if (_pkls.empty()) {
 		pkl = make_shared<PKL>(standard, annotation_text, issue_date, issuer, creator);
 		_pkls.push_back (pkl);
-		for (auto i: assets()) {
+		auto all = assets ();
+		if (hash_threads > 1) {
+			/* Hash the assets in parallel now rather than one by one as they are added */
+			hash_assets (vector<shared_ptr<const Asset>>(all.begin(), all.end()), hash_threads);
+		}
+		for (auto i: all) {
 			i->add_to_pkl (pkl, _directory);
 		}
         } else {
@@ -546,22 +725,18 @@ vector<shared_ptr<Asset>>
 DCP::assets (bool ignore_unresolved) const
 {
 	vector<shared_ptr<Asset>> assets;
+	/* IDs of everything in assets */
+	unordered_set<string> ids;
 	for (auto i: cpls()) {
 		assets.push_back (i);
+		ids.insert (i->id());
 		for (auto j: i->reel_file_assets()) {
 			if (ignore_unresolved && !j->asset_ref().resolved()) {
 				continue;
 			}
 
-			auto const id = j->asset_ref().id();
-			auto already_got = false;
-			for (auto k: assets) {
-				if (k->id() == id) {
-					already_got = true;
-				}
-			}
-
-			if (!already_got) {
+			if (ids.find(j->asset_ref().id()) == ids.end()) {
+				auto const first_new = assets.size();
 				auto o = j->asset_ref().asset();
 				assets.push_back (o);
 				/* More Interop special-casing */
@@ -569,6 +744,9 @@ DCP::assets (bool ignore_unresolved) const
 				if (sub) {
 					sub->add_font_assets (assets);
 				}
+				for (auto k = first_new; k < assets.size(); ++k) {
+					ids.insert (assets[k]->id());
+				}
 			}
 		}
 	}
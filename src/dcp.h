@@ -66,6 +66,7 @@ namespace dcp
 {
 
 
+class AssetIndex;
 class PKL;
 class Content;
 class Reel;
@@ -111,8 +112,21 @@ public:
 	 *  @param ignore_incorrect_picture_mxf_type true to try loading MXF files marked as monoscopic
 	 *  as stereoscopic if the monoscopic load fails; fixes problems some 3D DCPs that (I think)
 	 *  have an incorrect descriptor in their MXF.
+	 *  @param threads Number of MXF files to open at once.  Opening an MXF means waiting for
+	 *  several small reads, so on network storage it helps to have more than one going at once.
+	 *  @param lazy true to read only the ASSETMAP, PKLs and CPLs here, and to leave the other assets
+	 *  (MXFs and Interop subtitles) until they are first asked for with Ref::asset() (or anything that
+	 *  uses it, like DCP::assets()).  This saves time and memory when only the DCP's metadata is needed.
+	 *  Any errors in those assets are then thrown when they are asked for, and 3D assets marked as 2D are
+	 *  not noted.  An asset whose file gives a different ID to the ASSETMAP would not resolve any reference
+	 *  in a normal read; here the reference looks resolved but asking for the asset throws UnresolvedRefError.
 	 */
-	void read (std::vector<VerificationNote>* notes = nullptr, bool ignore_incorrect_picture_mxf_type = false);
+	void read (
+		std::vector<VerificationNote>* notes = nullptr,
+		bool ignore_incorrect_picture_mxf_type = false,
+		int threads = 1,
+		bool lazy = false
+		);
 
 	/** Compare this DCP with another, according to various options.
 	 *  @param other DCP to compare this one to.
@@ -149,6 +163,8 @@ public:
 	 *  @param annotation_text Value for the CPL <AnnotationText> tags
 	 *  @param signer Signer to use
 	 *  @param name_format Name format to use for the CPL and PKL filenames
+	 *  @param hash_threads Number of asset files to hash at once when making the PKL (see hash_assets());
+	 *  1 hashes them one after another.
 	 */
 	void write_xml (
 		std::string issuer = String::compose("libdcp %1", dcp::version),
@@ -156,10 +172,12 @@ public:
 		std::string issue_date = LocalTime().as_string(),
 		std::string annotation_text = String::compose("Created by libdcp %1", dcp::version),
 		std::shared_ptr<const CertificateChain> signer = std::shared_ptr<const CertificateChain>(),
-		NameFormat name_format = NameFormat("%t")
+		NameFormat name_format = NameFormat("%t"),
+		int hash_threads = 1
 	);
 
 	void resolve_refs (std::vector<std::shared_ptr<Asset>> assets);
+	void resolve_refs (AssetIndex const& assets);
 
 	/** @return Standard of a DCP that was read in */
 	boost::optional<Standard> standard () const {
@@ -185,6 +203,8 @@ public:
 
 private:
 
+	friend class DCPCache;
+
 	void write_volindex (Standard standard) const;
 
 	/** Write the ASSETMAP file.
@@ -204,6 +224,10 @@ private:
 	std::vector<std::shared_ptr<PKL>> _pkls;
 	/** File that the ASSETMAP was read from or last written to */
 	mutable boost::optional<boost::filesystem::path> _asset_map;
+	/** If set, a directory containing copies of some or all of this DCP's ASSETMAP, PKLs and CPLs
+	 *  (at the same relative paths) which read() will use in preference to the originals.
+	 */
+	boost::optional<boost::filesystem::path> _metadata_directory;
 
 	/** Standard of DCP that was read in */
 	boost::optional<Standard> _standard;
@@ -0,0 +1,371 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+/** @file  src/dcp_cache.cc
+ *  @brief DCPCache class.
+ */
+
+
+#include "array_data.h"
+#include "cpl.h"
+#include "dcp.h"
+#include "dcp_cache.h"
+#include "pkl.h"
+#include "raw_convert.h"
+#include "util.h"
+#include <libcxml/cxml.h>
+#include <libxml++/libxml++.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using boost::optional;
+using namespace dcp;
+
+
+/** Version of the snapshot format; snapshots with any other version are not used */
+static int const snapshot_version = 2;
+
+
+/** Size and modification time of a file in a DCP */
+struct FileState
+{
+	FileState (string path_, int64_t size_, int64_t modified_)
+		: path (path_)
+		, size (size_)
+		, modified (modified_)
+	{}
+
+	/** path relative to the DCP's directory */
+	string path;
+	int64_t size;
+	/** modification time in seconds since the epoch */
+	int64_t modified;
+
+	bool operator== (FileState const& other) const {
+		return path == other.path && size == other.size && modified == other.modified;
+	}
+};
+
+
+/** @return State of every regular file in a directory and its subdirectories, in order of path */
+static vector<FileState>
+file_states (boost::filesystem::path directory)
+{
+	vector<FileState> states;
+	for (auto const& i: boost::filesystem::recursive_directory_iterator(directory)) {
+		if (boost::filesystem::is_regular_file(i.status())) {
+			states.push_back (
+				FileState(
+					i.path().string().substr(directory.string().length() + 1),
+					boost::filesystem::file_size(i.path()),
+					boost::filesystem::last_write_time(i.path())
+					)
+				);
+		}
+	}
+
+	std::sort (states.begin(), states.end(), [](FileState const& a, FileState const& b) {
+		return a.path < b.path;
+	});
+
+	return states;
+}
+
+
+/** @return file relative to directory, or nothing if file is not inside directory */
+static optional<boost::filesystem::path>
+relative_to (boost::filesystem::path file, boost::filesystem::path directory)
+{
+	auto i = file.begin();
+	for (auto const& j: directory) {
+		if (i == file.end() || *i != j) {
+			return {};
+		}
+		++i;
+	}
+
+	boost::filesystem::path relative;
+	for (; i != file.end(); ++i) {
+		if (*i == "..") {
+			return {};
+		}
+		relative /= *i;
+	}
+
+	if (relative.empty()) {
+		return {};
+	}
+
+	return relative;
+}
+
+
+/** What we know about a DCP from when it was last read in full */
+struct DCPCache::Snapshot
+{
+	/** State of the DCP's files before it was read */
+	vector<FileState> files;
+	bool ignore_incorrect_picture_mxf_type = false;
+	/** Notes from reading the DCP */
+	vector<VerificationNote> notes;
+	/** The DCP, or nullptr if the snapshot has been read from disk and not yet used */
+	shared_ptr<DCP> dcp;
+};
+
+
+static void
+add_note (xmlpp::Element* parent, VerificationNote const& note)
+{
+	auto node = parent->add_child("Note");
+	node->add_child("Type")->add_child_text (raw_convert<string>(static_cast<int>(note.type())));
+	node->add_child("Code")->add_child_text (raw_convert<string>(static_cast<int>(note.code())));
+	if (note.note()) {
+		node->add_child("Text")->add_child_text (*note.note());
+	}
+	if (note.file()) {
+		node->add_child("File")->add_child_text (note.file()->string());
+	}
+	if (note.line()) {
+		node->add_child("Line")->add_child_text (raw_convert<string>(*note.line()));
+	}
+}
+
+
+static VerificationNote
+read_note (cxml::ConstNodePtr node)
+{
+	auto const type = static_cast<VerificationNote::Type>(node->number_child<int>("Type"));
+	auto const code = static_cast<VerificationNote::Code>(node->number_child<int>("Code"));
+	auto const text = node->optional_string_child("Text");
+	auto const file = node->optional_string_child("File");
+	auto const line = node->optional_number_child<uint64_t>("Line");
+
+	if (text && file && line) {
+		return VerificationNote (type, code, *text, boost::filesystem::path(*file), *line);
+	} else if (text && file) {
+		return VerificationNote (type, code, *text, boost::filesystem::path(*file));
+	} else if (file) {
+		return VerificationNote (type, code, boost::filesystem::path(*file));
+	} else if (text) {
+		return VerificationNote (type, code, *text);
+	}
+
+	return VerificationNote (type, code);
+}
+
+
+DCPCache::DCPCache (boost::filesystem::path directory)
+	: _directory (directory)
+{
+	boost::filesystem::create_directories (_directory);
+}
+
+
+boost::filesystem::path
+DCPCache::snapshot_directory (boost::filesystem::path dcp_directory) const
+{
+	auto const name = dcp_directory.string();
+	auto digest = make_digest (ArrayData(reinterpret_cast<uint8_t const*>(name.c_str()), name.length()));
+	/* Make the base64 digest safe to use as a filename */
+	std::replace (digest.begin(), digest.end(), '/', '_');
+	std::replace (digest.begin(), digest.end(), '+', '-');
+	return _directory / digest;
+}
+
+
+/** @return The snapshot on disk of the DCP in dcp_directory, without its DCP, or nullptr if there is none */
+shared_ptr<DCPCache::Snapshot>
+DCPCache::read_snapshot (boost::filesystem::path dcp_directory) const
+{
+	auto const manifest = snapshot_directory(dcp_directory) / "manifest.xml";
+	if (!boost::filesystem::exists(manifest)) {
+		return {};
+	}
+
+	try {
+		cxml::Document doc ("DCPCache");
+		doc.read_file (manifest);
+		if (doc.number_child<int>("Version") != snapshot_version || doc.string_child("Directory") != dcp_directory.string()) {
+			return {};
+		}
+
+		auto snapshot = make_shared<Snapshot>();
+		for (auto i: doc.node_children("File")) {
+			snapshot->files.push_back (FileState(i->string_child("Path"), i->number_child<int64_t>("Size"), i->number_child<int64_t>("Modified")));
+		}
+		snapshot->ignore_incorrect_picture_mxf_type = doc.number_child<int>("IgnoreIncorrectPictureMXFType") != 0;
+		for (auto i: doc.node_children("Note")) {
+			snapshot->notes.push_back (read_note(i));
+		}
+		return snapshot;
+	} catch (std::exception&) {
+		/* A snapshot that we can't read is no use, but it will be replaced */
+		return {};
+	}
+}
+
+
+/** Write a snapshot of a DCP which has been read to disk */
+void
+DCPCache::write_snapshot (boost::filesystem::path dcp_directory, shared_ptr<const Snapshot> snapshot) const
+{
+	auto dcp = snapshot->dcp;
+
+	vector<boost::filesystem::path> metadata;
+	if (auto asset_map = dcp->asset_map_path()) {
+		metadata.push_back (*asset_map);
+	}
+	for (auto i: dcp->pkls()) {
+		if (auto file = i->file()) {
+			metadata.push_back (*file);
+		}
+	}
+	for (auto i: dcp->cpls()) {
+		if (auto file = i->file()) {
+			metadata.push_back (*file);
+		}
+	}
+
+	/* Build the snapshot next to where it will go and then move it into place, so that
+	   nothing ever sees a snapshot which is only partly written.
+	*/
+	auto const directory = snapshot_directory (dcp_directory);
+	boost::filesystem::path const temporary = directory.string() + "." + make_uuid();
+
+	try {
+		boost::filesystem::create_directories (temporary / "dcp");
+
+		for (auto i: metadata) {
+			auto relative = relative_to (i, dcp_directory);
+			if (!relative) {
+				continue;
+			}
+			auto const copy = temporary / "dcp" / *relative;
+			if (!boost::filesystem::exists(copy)) {
+				boost::filesystem::create_directories (copy.parent_path());
+				boost::filesystem::copy_file (i, copy);
+			}
+		}
+
+		xmlpp::Document doc;
+		auto root = doc.create_root_node ("DCPCache");
+		root->add_child("Version")->add_child_text (raw_convert<string>(snapshot_version));
+		root->add_child("Directory")->add_child_text (dcp_directory.string());
+		for (auto const& i: snapshot->files) {
+			auto file = root->add_child("File");
+			file->add_child("Path")->add_child_text (i.path);
+			file->add_child("Size")->add_child_text (raw_convert<string>(i.size));
+			file->add_child("Modified")->add_child_text (raw_convert<string>(i.modified));
+		}
+		root->add_child("IgnoreIncorrectPictureMXFType")->add_child_text (snapshot->ignore_incorrect_picture_mxf_type ? "1" : "0");
+		for (auto const& i: snapshot->notes) {
+			add_note (root, i);
+		}
+		doc.write_to_file_formatted ((temporary / "manifest.xml").string(), "UTF-8");
+
+		boost::filesystem::remove_all (directory);
+		boost::filesystem::rename (temporary, directory);
+	} catch (std::exception&) {
+		/* Without a snapshot the DCP will just be read in full next time */
+		boost::system::error_code ec;
+		boost::filesystem::remove_all (temporary, ec);
+	}
+}
+
+
+shared_ptr<DCP>
+DCPCache::read (boost::filesystem::path dcp_directory, vector<VerificationNote>* notes, bool ignore_incorrect_picture_mxf_type)
+{
+	auto dcp = make_shared<DCP>(dcp_directory);
+	auto const directory = dcp->directory();
+
+	/* Look at the files before reading them, so that any change made while we are reading
+	   means that the snapshot we take will not be used.
+	*/
+	auto const files = file_states (directory);
+
+	auto usable = [&files, ignore_incorrect_picture_mxf_type](shared_ptr<const Snapshot> snapshot) {
+		return snapshot && snapshot->files == files && snapshot->ignore_incorrect_picture_mxf_type == ignore_incorrect_picture_mxf_type;
+	};
+
+	auto snapshot = _snapshots[directory];
+	if (!usable(snapshot)) {
+		snapshot = read_snapshot (directory);
+	}
+
+	if (usable(snapshot) && !snapshot->dcp) {
+		/* The asset files were checked when the snapshot was taken, so they need not be opened now */
+		try {
+			dcp->_metadata_directory = snapshot_directory(directory) / "dcp";
+			dcp->read (nullptr, ignore_incorrect_picture_mxf_type, 1, true);
+			dcp->_metadata_directory = boost::none;
+			snapshot->dcp = dcp;
+		} catch (std::exception&) {
+			/* Perhaps the snapshot's copies have been damaged; read the DCP in full instead */
+			snapshot.reset ();
+			dcp = make_shared<DCP>(directory);
+		}
+	}
+
+	if (usable(snapshot)) {
+		++_hits;
+		_snapshots[directory] = snapshot;
+		if (notes) {
+			notes->insert (notes->end(), snapshot->notes.begin(), snapshot->notes.end());
+		}
+		return snapshot->dcp;
+	}
+
+	++_misses;
+	_snapshots.erase (directory);
+
+	snapshot = make_shared<Snapshot>();
+	snapshot->files = files;
+	snapshot->ignore_incorrect_picture_mxf_type = ignore_incorrect_picture_mxf_type;
+	dcp->read (&snapshot->notes, ignore_incorrect_picture_mxf_type);
+	snapshot->dcp = dcp;
+
+	write_snapshot (directory, snapshot);
+	_snapshots[directory] = snapshot;
+
+	if (notes) {
+		notes->insert (notes->end(), snapshot->notes.begin(), snapshot->notes.end());
+	}
+	return dcp;
+}
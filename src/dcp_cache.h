@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+/** @file  src/dcp_cache.h
+ *  @brief DCPCache class.
+ */
+
+
+#ifndef LIBDCP_DCP_CACHE_H
+#define LIBDCP_DCP_CACHE_H
+
+
+#include "verify.h"
+#include <boost/filesystem.hpp>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+namespace dcp {
+
+
+class DCP;
+
+
+/** @class DCPCache
+ *  @brief A store of snapshots of DCPs' metadata, so that DCPs which have not changed
+ *  can be read again without reading their XML.
+ *
+ *  A snapshot of a DCP records the size and modification time of every file in the DCP's
+ *  directory, and any notes that came from reading it.  If none of those files have changed
+ *  since the snapshot was taken, the DCP is not read again:
+ *
+ *  - if the snapshot was taken by this DCPCache, the DCP that was read then is returned,
+ *    so no XML is parsed and no asset files are opened.
+ *  - otherwise the snapshot's copies of the DCP's ASSETMAP, PKLs and CPLs are read, which
+ *    saves reading them from the DCP's own storage when that is slow (on a network, say).
+ *    This read is lazy (see DCP::read()) as the asset files were checked when the snapshot
+ *    was taken.
+ *
+ *  When there is no up-to-date snapshot the DCP is read in full, so that any errors in its
+ *  asset files are found as they would be without a cache, and a new snapshot is taken.
+ *  If such a read throws an exception no snapshot is taken, so the next read will throw too.
+ *
+ *  Modification times are only compared to the nearest second.
+ */
+class DCPCache
+{
+public:
+	/** @param directory Directory to keep snapshots in; it will be created if it does not exist */
+	explicit DCPCache (boost::filesystem::path directory);
+
+	/** Read a DCP, using a snapshot if there is an up-to-date one.
+	 *  The other parameters are as for DCP::read(); any notes are the same whether or not a snapshot
+	 *  is used.
+	 *  @param dcp_directory Directory of the DCP.
+	 *  @return The DCP.  This may be the same object as an earlier call returned, so it should not be
+	 *  changed.
+	 */
+	std::shared_ptr<DCP> read (
+		boost::filesystem::path dcp_directory,
+		std::vector<VerificationNote>* notes = nullptr,
+		bool ignore_incorrect_picture_mxf_type = false
+		);
+
+	/** @return Number of calls to read() which used a snapshot */
+	int hits () const {
+		return _hits;
+	}
+
+	/** @return Number of calls to read() which had to read a DCP in full */
+	int misses () const {
+		return _misses;
+	}
+
+private:
+	struct Snapshot;
+
+	boost::filesystem::path snapshot_directory (boost::filesystem::path dcp_directory) const;
+	std::shared_ptr<Snapshot> read_snapshot (boost::filesystem::path dcp_directory) const;
+	void write_snapshot (boost::filesystem::path dcp_directory, std::shared_ptr<const Snapshot> snapshot) const;
+
+	boost::filesystem::path _directory;
+	/** Snapshots that we have taken or read, keyed by the DCP's directory */
+	std::map<boost::filesystem::path, std::shared_ptr<Snapshot>> _snapshots;
+	int _hits = 0;
+	int _misses = 0;
+};
+
+
+}
+
+
+#endif
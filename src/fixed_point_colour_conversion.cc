@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/fixed_point_colour_conversion.cc
+ *  @brief FixedPointColourConversion class
+ */
+
+
+#include "colour_conversion.h"
+#include "fixed_point_colour_conversion.h"
+#include "rgb_xyz.h"
+#include "transfer_function.h"
+#include <cmath>
+
+
+using namespace dcp;
+
+
+static auto constexpr DCI_COEFFICIENT = 48.0 / 52.37;
+
+
+FixedPointColourConversion::FixedPointColourConversion (ColourConversion const& conversion)
+	: _rgb_to_xyz_in (4096)
+	, _rgb_to_xyz_out (65536)
+	, _xyz_to_rgb_in (4096)
+	, _xyz_to_rgb_out (65536)
+	, _xyz_to_rgba_out (65536)
+{
+	double const input_one = int64_t(1) << input_fraction_bits;
+	double const matrix_one = int64_t(1) << matrix_fraction_bits;
+
+	/* RGB to XYZ */
+
+	auto lut_in = conversion.in()->lut (12, false);
+	for (int i = 0; i < 4096; ++i) {
+		_rgb_to_xyz_in[i] = llrint (lut_in[i] * input_one);
+	}
+
+	/* This already scales its output to 0-65535 */
+	double matrix[9];
+	combined_rgb_to_xyz (conversion, matrix);
+	for (int i = 0; i < 9; ++i) {
+		_rgb_to_xyz_matrix[i] = llrint (matrix[i] * matrix_one);
+	}
+
+	auto lut_out = conversion.out()->lut (16, true);
+	for (int i = 0; i < 65536; ++i) {
+		_rgb_to_xyz_out[i] = lrint (lut_out[i] * 4095);
+	}
+
+	/* XYZ to RGB */
+
+	lut_in = conversion.out()->lut (12, false);
+	for (int i = 0; i < 4096; ++i) {
+		_xyz_to_rgb_in[i] = llrint (lut_in[i] * input_one / DCI_COEFFICIENT);
+	}
+
+	auto const xyz_to_rgb = conversion.xyz_to_rgb ();
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			_xyz_to_rgb_matrix[i * 3 + j] = llrint (xyz_to_rgb(i, j) * 65535 * matrix_one);
+		}
+	}
+
+	lut_out = conversion.in()->lut (16, true);
+	for (int i = 0; i < 65536; ++i) {
+		_xyz_to_rgb_out[i] = lrint (lut_out[i] * 65535);
+		_xyz_to_rgba_out[i] = lut_out[i] * 0xff;
+	}
+}
@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/fixed_point_colour_conversion.h
+ *  @brief FixedPointColourConversion class
+ */
+
+
+#ifndef LIBDCP_FIXED_POINT_COLOUR_CONVERSION_H
+#define LIBDCP_FIXED_POINT_COLOUR_CONVERSION_H
+
+
+#include <stdint.h>
+#include <vector>
+
+
+namespace dcp {
+
+
+class ColourConversion;
+
+
+/** @class FixedPointColourConversion
+ *  @brief Tables to do a ColourConversion using integer arithmetic.
+ *
+ *  The conversion is done in the same way as the exact (double-precision) one: an input
+ *  gamma LUT, a 3x3 matrix and an output gamma LUT.  Here, though, the input LUT and matrix are
+ *  fixed-point integers and the output LUT gives final output values directly, so there is no
+ *  floating-point arithmetic or rounding per pixel, and the tables are a quarter of the size.
+ *  Results are within a count or so of the exact conversion; benchmark/fixed_point_colour_conversion
+ *  reports the actual differences.
+ *
+ *  Making the tables takes a few milliseconds so it is worth making one of these and then using
+ *  it for many frames.
+ */
+class FixedPointColourConversion
+{
+public:
+	explicit FixedPointColourConversion (ColourConversion const& conversion);
+
+	/** Number of fractional bits in the input LUTs.  This needs to be large as linear values
+	 *  close to black are very small, and the output LUTs are very steep there.
+	 */
+	static int constexpr input_fraction_bits = 30;
+	/** Number of fractional bits in the matrices */
+	static int constexpr matrix_fraction_bits = 8;
+	/** Shift to apply, after multiplying an input vector by a matrix, to get an index into an output LUT */
+	static int constexpr shift = input_fraction_bits + matrix_fraction_bits;
+
+	/** @return 12-bit RGB to linear RGB, with input_fraction_bits fractional bits */
+	int64_t const * rgb_to_xyz_in () const {
+		return _rgb_to_xyz_in.data();
+	}
+
+	/** @return Matrix from linear RGB to linear XYZ in 0-65535, with matrix_fraction_bits fractional bits */
+	int64_t const * rgb_to_xyz_matrix () const {
+		return _rgb_to_xyz_matrix;
+	}
+
+	/** @return 16-bit linear XYZ to 12-bit XYZ */
+	uint16_t const * rgb_to_xyz_out () const {
+		return _rgb_to_xyz_out.data();
+	}
+
+	/** @return 12-bit XYZ to linear XYZ, with input_fraction_bits fractional bits */
+	int64_t const * xyz_to_rgb_in () const {
+		return _xyz_to_rgb_in.data();
+	}
+
+	/** @return Matrix from linear XYZ to linear RGB in 0-65535, with matrix_fraction_bits fractional bits */
+	int64_t const * xyz_to_rgb_matrix () const {
+		return _xyz_to_rgb_matrix;
+	}
+
+	/** @return 16-bit linear RGB to 16-bit RGB */
+	uint16_t const * xyz_to_rgb_out () const {
+		return _xyz_to_rgb_out.data();
+	}
+
+	/** @return 16-bit linear RGB to 8-bit RGB */
+	uint8_t const * xyz_to_rgba_out () const {
+		return _xyz_to_rgba_out.data();
+	}
+
+private:
+	std::vector<int64_t> _rgb_to_xyz_in;
+	int64_t _rgb_to_xyz_matrix[9];
+	std::vector<uint16_t> _rgb_to_xyz_out;
+
+	std::vector<int64_t> _xyz_to_rgb_in;
+	int64_t _xyz_to_rgb_matrix[9];
+	std::vector<uint16_t> _xyz_to_rgb_out;
+	std::vector<uint8_t> _xyz_to_rgba_out;
+};
+
+
+}
+
+
+#endif
@@ -43,6 +43,7 @@
 
 #include "crypto_context.h"
 #include "exceptions.h"
+#include "frame_buffer_pool.h"
 #include <asdcp/KM_fileio.h>
 #include <asdcp/AS_DCP.h>
 
@@ -54,12 +55,19 @@ template <class R, class B>
 class Frame
 {
 public:
-	Frame (R* reader, int n, std::shared_ptr<const DecryptionContext> c, bool check_hmac)
+	typedef B Buffer;
+
+	/** XXX: unfortunate guesswork on this buffer size */
+	static int constexpr initial_buffer_capacity = Kumu::Megabyte;
+
+	/** @param pool Pool to get the buffer from, or nullptr to use a buffer of our own */
+	Frame (R* reader, int n, std::shared_ptr<const DecryptionContext> c, bool check_hmac, std::shared_ptr<FrameBufferPool<B>> pool = nullptr)
 	{
-		/* XXX: unfortunate guesswork on this buffer size */
-		_buffer = std::make_shared<B>(Kumu::Megabyte);
+		if (!pool) {
+			pool = std::make_shared<FrameBufferPool<B>>(initial_buffer_capacity);
+		}
 
-		if (ASDCP_FAILURE(reader->ReadFrame(n, *_buffer, c->context(), check_hmac ? c->hmac() : nullptr))) {
+		if (ASDCP_FAILURE(pool->read(reader, n, *c, check_hmac, _buffer))) {
 			boost::throw_exception (ReadError ("could not read frame"));
 		}
 	}
@@ -82,6 +90,10 @@ private:
 };
 
 
+template <class R, class B>
+int constexpr Frame<R, B>::initial_buffer_capacity;
+
+
 }
 
 
@@ -0,0 +1,194 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/frame_buffer_pool.h
+ *  @brief FrameBufferPool class
+ */
+
+
+#ifndef LIBDCP_FRAME_BUFFER_POOL_H
+#define LIBDCP_FRAME_BUFFER_POOL_H
+
+
+#include "crypto_context.h"
+#include "warnings.h"
+LIBDCP_DISABLE_WARNINGS
+#include <asdcp/AS_DCP.h>
+LIBDCP_ENABLE_WARNINGS
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+
+namespace dcp {
+
+
+inline void
+set_frame_buffer_capacity (ASDCP::FrameBuffer& buffer, int capacity)
+{
+	buffer.Capacity (capacity);
+}
+
+
+inline void
+set_frame_buffer_capacity (ASDCP::JP2K::SFrameBuffer& buffer, int capacity)
+{
+	buffer.Left.Capacity (capacity);
+	buffer.Right.Capacity (capacity);
+}
+
+
+/** @class FrameBufferPool
+ *  @brief A pool of asdcplib frame buffers for an AssetReader to read frames into.
+ *
+ *  When a frame that was read into one of these buffers is destroyed its buffer comes
+ *  back to the pool, so a reader that is used to read frames one after another does not
+ *  need to allocate (and page in) a new multi-megabyte buffer for each one.
+ *
+ *  Buffers start off with a guessed capacity; if a frame turns out to be bigger than that
+ *  its buffer's capacity is doubled until it fits, and all later buffers are made at the new size.
+ */
+template <class B>
+class FrameBufferPool : public std::enable_shared_from_this<FrameBufferPool<B>>
+{
+public:
+	explicit FrameBufferPool (int capacity)
+		: _capacity (capacity)
+	{}
+
+	~FrameBufferPool ()
+	{
+		for (auto i: _free) {
+			delete i;
+		}
+	}
+
+	FrameBufferPool (FrameBufferPool const&) = delete;
+	FrameBufferPool& operator= (FrameBufferPool const&) = delete;
+
+	/** Read a frame into a buffer from this pool.
+	 *  @param reader Reader to read with.
+	 *  @param n Frame index.
+	 *  @param context Decryption context.
+	 *  @param check_hmac true to check the frame's HMAC.
+	 *  @param buffer Filled in with the buffer containing the frame.
+	 *  @return Result from asdcplib.
+	 */
+	template <class R>
+	ASDCP::Result_t read (R* reader, int n, DecryptionContext const& context, bool check_hmac, std::shared_ptr<B>& buffer)
+	{
+		int capacity = this->capacity ();
+		buffer = get (capacity);
+		while (true) {
+			auto const r = reader->ReadFrame (n, *buffer, context.context(), check_hmac ? context.hmac() : nullptr);
+			if (r != Kumu::RESULT_SMALLBUF || capacity >= max_capacity) {
+				if (ASDCP_SUCCESS(r)) {
+					/* Make future buffers big enough for this frame */
+					boost::mutex::scoped_lock lm (_mutex);
+					_capacity = std::max (_capacity, capacity);
+				}
+				return r;
+			}
+			capacity *= 2;
+			set_frame_buffer_capacity (*buffer, capacity);
+		}
+	}
+
+	/** @return Capacity of the buffers that are currently being made */
+	int capacity () const {
+		boost::mutex::scoped_lock lm (_mutex);
+		return _capacity;
+	}
+
+private:
+	/** @return A buffer from the pool, or a new one if there are none free */
+	std::shared_ptr<B> get (int capacity)
+	{
+		B* buffer = nullptr;
+		{
+			boost::mutex::scoped_lock lm (_mutex);
+			if (!_free.empty()) {
+				buffer = _free.back ();
+				_free.pop_back ();
+			}
+		}
+
+		if (buffer) {
+			/* This does nothing if the buffer is already big enough */
+			set_frame_buffer_capacity (*buffer, capacity);
+		} else {
+			buffer = new B (capacity);
+		}
+
+		/* Return the buffer to the pool when the last reference to it goes, as long as
+		   the pool is still around.
+		*/
+		std::weak_ptr<FrameBufferPool> weak = this->shared_from_this ();
+		return std::shared_ptr<B> (buffer, [weak](B* b) {
+			auto pool = weak.lock ();
+			if (pool) {
+				pool->put (b);
+			} else {
+				delete b;
+			}
+		});
+	}
+
+	void put (B* buffer)
+	{
+		boost::mutex::scoped_lock lm (_mutex);
+		if (_free.size() < max_free) {
+			_free.push_back (buffer);
+		} else {
+			delete buffer;
+		}
+	}
+
+	/** Maximum number of spare buffers to keep */
+	static size_t constexpr max_free = 4;
+	static int constexpr max_capacity = 256 * Kumu::Megabyte;
+
+	mutable boost::mutex _mutex;
+	/** Capacity that new buffers are made with */
+	int _capacity;
+	std::vector<B*> _free;
+};
+
+
+}
+
+
+#endif
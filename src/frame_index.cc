@@ -0,0 +1,217 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/frame_index.cc
+ *  @brief FrameIndex class.
+ */
+
+
+#include "dcp_assert.h"
+#include "exceptions.h"
+#include "frame_index.h"
+#include "mapped_file.h"
+#include "util.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+
+using std::make_shared;
+using std::max;
+using std::min;
+using std::shared_ptr;
+using namespace dcp;
+
+
+/* This is only used here, so keep it out of the way of any other Header */
+namespace {
+
+
+/** Header of a sidecar file, which is followed by the entries.  Both are written in the
+ *  machine's own byte order so that the file can be used as it is once mapped; a file
+ *  from a machine with the other byte order will fail the version check and be ignored.
+ */
+struct Header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t entry_size;
+	uint64_t count;
+	/** size of the MXF when the index was written */
+	uint64_t mxf_size;
+	/** modification time of the MXF when the index was written */
+	int64_t mxf_modified;
+	uint64_t total_essence_size;
+	uint32_t min_essence_size;
+	uint32_t max_essence_size;
+};
+
+
+}
+
+
+static char const magic[8] = { 'L', 'D', 'C', 'P', 'F', 'I', 'D', 'X' };
+static uint32_t const version = 1;
+
+
+boost::filesystem::path
+FrameIndex::sidecar (boost::filesystem::path mxf)
+{
+	mxf += ".fidx";
+	return mxf;
+}
+
+
+void
+FrameIndex::add (Entry entry)
+{
+	if (_entries.empty()) {
+		_min_essence_size = _max_essence_size = entry.essence_size;
+	} else {
+		_min_essence_size = min (_min_essence_size, entry.essence_size);
+		_max_essence_size = max (_max_essence_size, entry.essence_size);
+	}
+	_total_essence_size += entry.essence_size;
+
+	_entries.push_back (entry);
+	_data = _entries.data();
+	_count = _entries.size();
+}
+
+
+FrameIndex::Entry const&
+FrameIndex::operator[] (int64_t n) const
+{
+	DCP_ASSERT (n >= 0 && n < _count);
+	return _data[n];
+}
+
+
+void
+FrameIndex::write (boost::filesystem::path mxf) const
+{
+	Header header;
+	memset (&header, 0, sizeof(header));
+	memcpy (header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.entry_size = sizeof(Entry);
+	header.count = _count;
+	header.mxf_size = boost::filesystem::file_size (mxf);
+	header.mxf_modified = boost::filesystem::last_write_time (mxf);
+	header.total_essence_size = _total_essence_size;
+	header.min_essence_size = _min_essence_size;
+	header.max_essence_size = _max_essence_size;
+
+	/* Write to a temporary file and then rename it, so that nobody can load a half-written index */
+	auto const file = sidecar (mxf);
+	auto temp = file;
+	temp += ".tmp";
+
+	auto f = fopen_boost (temp, "wb");
+	if (!f) {
+		boost::throw_exception (FileError("could not open frame index for writing", temp, errno));
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	if (ok && _count > 0) {
+		ok = fwrite(_data, sizeof(Entry), _count, f) == static_cast<size_t>(_count);
+	}
+	ok = fclose(f) == 0 && ok;
+
+	if (!ok) {
+		boost::system::error_code ec;
+		boost::filesystem::remove (temp, ec);
+		boost::throw_exception (FileError("could not write frame index", temp, errno));
+	}
+
+	boost::filesystem::rename (temp, file);
+}
+
+
+shared_ptr<const FrameIndex>
+FrameIndex::load (boost::filesystem::path mxf)
+{
+	auto const file = sidecar (mxf);
+
+	boost::system::error_code ec;
+	if (!boost::filesystem::is_regular_file(file, ec)) {
+		return {};
+	}
+
+	auto const mxf_size = boost::filesystem::file_size (mxf, ec);
+	if (ec) {
+		return {};
+	}
+	auto const mxf_modified = boost::filesystem::last_write_time (mxf, ec);
+	if (ec) {
+		return {};
+	}
+
+	shared_ptr<MappedFile> mapped;
+	try {
+		mapped = make_shared<MappedFile>(file);
+	} catch (FileError &) {
+		return {};
+	}
+
+	if (mapped->size() < sizeof(Header)) {
+		return {};
+	}
+
+	Header header;
+	memcpy (&header, mapped->data(), sizeof(header));
+	if (
+		memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+		header.version != version ||
+		header.entry_size != sizeof(Entry) ||
+		header.count > (mapped->size() - sizeof(Header)) / sizeof(Entry) ||
+		mapped->size() != sizeof(Header) + header.count * sizeof(Entry) ||
+		header.mxf_size != mxf_size ||
+		header.mxf_modified != mxf_modified
+	   ) {
+		/* Either this isn't an index that we can use, or the MXF has changed since it was written */
+		return {};
+	}
+
+	auto index = make_shared<FrameIndex>();
+	index->_file = mapped;
+	index->_data = reinterpret_cast<Entry const *>(mapped->data() + sizeof(Header));
+	index->_count = header.count;
+	index->_min_essence_size = header.min_essence_size;
+	index->_max_essence_size = header.max_essence_size;
+	index->_total_essence_size = header.total_essence_size;
+	return index;
+}
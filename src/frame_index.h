@@ -0,0 +1,135 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/frame_index.h
+ *  @brief FrameIndex class.
+ */
+
+
+#ifndef LIBDCP_FRAME_INDEX_H
+#define LIBDCP_FRAME_INDEX_H
+
+
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+
+namespace dcp {
+
+
+class MappedFile;
+
+
+/** @class FrameIndex
+ *  @brief The position and size of every frame in a picture MXF.
+ *
+ *  A FrameIndex can be written by a PictureAssetWriter to a sidecar file next to the MXF
+ *  (see PictureAssetWriter::set_write_frame_index()), and then loaded much more quickly than
+ *  the same information could be found from the MXF.  A loaded index is mapped into memory, so
+ *  looking up a frame does not need to read the whole index.
+ *
+ *  For stereoscopic assets there are two entries per frame: left eye then right eye.
+ */
+class FrameIndex
+{
+public:
+	struct Entry
+	{
+		/** offset of the frame's KLV packet in the MXF, as in FrameInfo */
+		uint64_t offset;
+		/** size of the frame's KLV packet, as in FrameInfo */
+		uint32_t size;
+		/** size of the frame's JPEG2000 codestream */
+		uint32_t essence_size;
+	};
+
+	FrameIndex () {}
+
+	FrameIndex (FrameIndex const&) = delete;
+	FrameIndex& operator= (FrameIndex const&) = delete;
+
+	void add (Entry entry);
+
+	/** Write this index to the sidecar file for a MXF.
+	 *  @param mxf MXF that the index describes; it must be complete.
+	 */
+	void write (boost::filesystem::path mxf) const;
+
+	/** @param mxf MXF file.
+	 *  @return Index from the sidecar file for mxf, or nullptr if there is no sidecar or it is out of date.
+	 */
+	static std::shared_ptr<const FrameIndex> load (boost::filesystem::path mxf);
+
+	/** @return Path of the sidecar file for a MXF */
+	static boost::filesystem::path sidecar (boost::filesystem::path mxf);
+
+	/** @return Number of entries */
+	int64_t size () const {
+		return _count;
+	}
+
+	Entry const& operator[] (int64_t n) const;
+
+	uint32_t min_essence_size () const {
+		return _min_essence_size;
+	}
+
+	uint32_t max_essence_size () const {
+		return _max_essence_size;
+	}
+
+	uint64_t total_essence_size () const {
+		return _total_essence_size;
+	}
+
+private:
+	std::vector<Entry> _entries;
+	/** sidecar that we were loaded from, if any */
+	std::shared_ptr<MappedFile> _file;
+	/** pointer to either _entries or the entries in _file */
+	Entry const * _data = nullptr;
+	int64_t _count = 0;
+	uint32_t _min_essence_size = 0;
+	uint32_t _max_essence_size = 0;
+	uint64_t _total_essence_size = 0;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,221 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/frame_prefetcher.h
+ *  @brief FramePrefetcher class.
+ */
+
+
+#ifndef LIBDCP_FRAME_PREFETCHER_H
+#define LIBDCP_FRAME_PREFETCHER_H
+
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+namespace dcp {
+
+
+/** @class FramePrefetcher
+ *  @brief Reads frames on a background thread, ahead of the frame that was last asked for.
+ *
+ *  This is used by AssetReader when prefetching is turned on (see AssetReader::set_prefetch()).
+ *  It holds up to a given number of frames which follow the last one that was asked for, so
+ *  a caller asking for frames in order should rarely have to wait for one to be read.  Asking
+ *  for any other frame counts as a seek: the frames that have been read ahead are thrown away
+ *  and reading starts again from the new position.
+ *
+ *  Nothing past the last frame of the asset is read ahead; such a frame is only read if it is
+ *  asked for, so that the caller gets the error.
+ */
+template <class F>
+class FramePrefetcher
+{
+public:
+	/** @param read Function to read a frame; this is called only from the prefetcher's thread.
+	 *  @param depth Maximum number of frames to hold.
+	 *  @param frames Number of frames in the asset.
+	 */
+	FramePrefetcher (std::function<std::shared_ptr<const F> (int)> read, int depth, int64_t frames)
+		: _read (read)
+		, _depth (depth)
+		, _frames (frames)
+	{
+		_thread = std::thread (&FramePrefetcher::thread, this);
+	}
+
+	~FramePrefetcher ()
+	{
+		{
+			std::lock_guard<std::mutex> lm (_mutex);
+			_stop = true;
+		}
+		_space.notify_all ();
+		_thread.join ();
+	}
+
+	FramePrefetcher (FramePrefetcher const&) = delete;
+	FramePrefetcher& operator= (FramePrefetcher const&) = delete;
+
+	/** @return Frame n, waiting for it to be read if necessary.  If reading it failed the
+	 *  exception is thrown from here.
+	 */
+	std::shared_ptr<const F> get (int n)
+	{
+		std::unique_lock<std::mutex> lm (_mutex);
+
+		if (!_started || n < _start || n > _start + ready()) {
+			/* Throw away anything we have (or are reading) and start again from n */
+			_ready.clear ();
+			_start = n;
+			_started = true;
+			++_generation;
+		} else {
+			/* Skip any frames before n */
+			while (_start < n) {
+				_ready.pop_front ();
+				++_start;
+			}
+		}
+		_waiting = true;
+		_space.notify_all ();
+
+		_available.wait (lm, [this]() {
+			return !_ready.empty();
+		});
+		_waiting = false;
+
+		auto slot = _ready.front ();
+		_ready.pop_front ();
+		++_start;
+		lm.unlock ();
+		_space.notify_all ();
+
+		if (slot.error) {
+			std::rethrow_exception (slot.error);
+		}
+
+		return slot.frame;
+	}
+
+private:
+	struct Slot
+	{
+		std::shared_ptr<const F> frame;
+		std::exception_ptr error;
+	};
+
+	int ready () const {
+		return static_cast<int>(_ready.size());
+	}
+
+	/** @return true if the thread should read frame _start + ready() */
+	bool should_read () const {
+		if (!_started || ready() >= _depth) {
+			return false;
+		}
+		/* Read past the end only if get() is waiting for that frame */
+		return _start + ready() < _frames || (_waiting && ready() == 0);
+	}
+
+	void thread ()
+	{
+		std::unique_lock<std::mutex> lm (_mutex);
+
+		while (true) {
+			_space.wait (lm, [this]() {
+				return _stop || should_read();
+			});
+
+			if (_stop) {
+				return;
+			}
+
+			auto const n = _start + ready();
+			auto const generation = _generation;
+
+			lm.unlock ();
+			Slot slot;
+			try {
+				slot.frame = _read (n);
+			} catch (...) {
+				slot.error = std::current_exception ();
+			}
+			lm.lock ();
+
+			/* If there has been a seek while we were reading, this frame is no longer wanted */
+			if (generation == _generation) {
+				_ready.push_back (slot);
+				_available.notify_all ();
+			}
+		}
+	}
+
+	std::function<std::shared_ptr<const F> (int)> _read;
+	int const _depth;
+	int64_t const _frames;
+
+	/** mutex for everything below, apart from _thread */
+	std::mutex _mutex;
+	/** condition to tell the thread that there is space in _ready, or that it should stop */
+	std::condition_variable _space;
+	/** condition to tell get() that a frame has been added to _ready */
+	std::condition_variable _available;
+	/** frames that have been read, starting with frame _start */
+	std::deque<Slot> _ready;
+	int _start = 0;
+	/** false until the first frame has been asked for */
+	bool _started = false;
+	/** true while get() is waiting for frame _start */
+	bool _waiting = false;
+	/** incremented on each seek, so that the thread can tell if a frame that it has read is still wanted */
+	int _generation = 0;
+	bool _stop = false;
+
+	std::thread _thread;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,266 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/hash_assets.cc
+ *  @brief hash_assets function
+ */
+
+
+#include "asset.h"
+#include "compose.hpp"
+#include "hash_assets.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#ifndef LIBDCP_WINDOWS
+#include <sys/stat.h>
+#endif
+#ifdef LIBDCP_LINUX
+#include <sys/sysmacros.h>
+#endif
+
+
+using std::map;
+using std::max;
+using std::min;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using boost::function;
+using namespace dcp;
+
+
+/** @return An identifier for the device that @p file is on */
+static string
+device (boost::filesystem::path file)
+{
+#ifdef LIBDCP_WINDOWS
+	return file.root_name().string();
+#else
+	struct stat s;
+	if (stat(file.string().c_str(), &s) != 0) {
+		return {};
+	}
+	return String::compose("%1", s.st_dev);
+#endif
+}
+
+
+/** @return true if @p file is on a spinning disk, as far as we can tell */
+static bool
+rotational (boost::filesystem::path file)
+{
+#ifdef LIBDCP_LINUX
+	struct stat s;
+	if (stat(file.string().c_str(), &s) != 0) {
+		return false;
+	}
+
+	auto const base = boost::filesystem::path("/sys/dev/block") / String::compose("%1:%2", major(s.st_dev), minor(s.st_dev));
+	/* Partitions do not have a queue directory of their own, but their disk does */
+	for (auto dir: { base / "queue", base / ".." / "queue" }) {
+		std::ifstream f ((dir / "rotational").string());
+		int r = 0;
+		if (f >> r) {
+			return r == 1;
+		}
+	}
+#else
+	(void) file;
+#endif
+	return false;
+}
+
+
+int
+dcp::default_hash_threads ()
+{
+	return max (1, min(4, static_cast<int>(std::thread::hardware_concurrency())));
+}
+
+
+void
+dcp::hash_assets (vector<shared_ptr<const Asset>> assets, int threads, function<void (float)> progress)
+{
+	struct Job
+	{
+		shared_ptr<const Asset> asset;
+		uintmax_t size;
+		/** bytes of this job's file that have been hashed */
+		uintmax_t done;
+	};
+
+	/* Jobs for the files on one device */
+	struct Device
+	{
+		/** maximum number of files to hash at once */
+		int limit;
+		int active;
+		/** indices into jobs of the files still to hash, largest last */
+		vector<size_t> pending;
+	};
+
+	threads = max (1, threads);
+
+	vector<Job> jobs;
+	for (auto i: assets) {
+		if (i && i->file() && std::find_if(jobs.begin(), jobs.end(), [i](Job const& j) { return j.asset == i; }) == jobs.end()) {
+			jobs.push_back ({i, boost::filesystem::file_size(*i->file()), 0});
+		}
+	}
+
+	if (jobs.empty()) {
+		return;
+	}
+
+	map<string, Device> devices;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		auto const file = *jobs[i].asset->file();
+		auto const id = device (file);
+		if (devices.find(id) == devices.end()) {
+			devices[id] = { rotational(file) ? 1 : threads, 0, {} };
+		}
+		devices[id].pending.push_back (i);
+	}
+
+	/* Start the biggest files first so that we do not finish by waiting for one big file on its own */
+	for (auto& i: devices) {
+		std::sort (i.second.pending.begin(), i.second.pending.end(), [&jobs](size_t a, size_t b) {
+			return jobs[a].size < jobs[b].size;
+		});
+	}
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	size_t remaining = jobs.size();
+	int finished = 0;
+	std::exception_ptr error;
+
+	/* @return device with a file that we can start hashing now, or nullptr */
+	auto next_device = [&]() -> Device* {
+		Device* best = nullptr;
+		for (auto& i: devices) {
+			auto& d = i.second;
+			if (!d.pending.empty() && d.active < d.limit && (!best || jobs[d.pending.back()].size > jobs[best->pending.back()].size)) {
+				best = &d;
+			}
+		}
+		return best;
+	};
+
+	auto work = [&]() {
+		while (true) {
+			size_t index;
+			Device* device = nullptr;
+			{
+				std::unique_lock<std::mutex> lm (mutex);
+				condition.wait (lm, [&]() { return error || remaining == 0 || next_device(); });
+				if (error || remaining == 0) {
+					break;
+				}
+				device = next_device ();
+				index = device->pending.back ();
+				device->pending.pop_back ();
+				--remaining;
+				++device->active;
+			}
+
+			auto& job = jobs[index];
+			try {
+				job.asset->hash ([&](float p) {
+					std::lock_guard<std::mutex> lm (mutex);
+					job.done = static_cast<uintmax_t>(p * job.size);
+				});
+			} catch (...) {
+				std::lock_guard<std::mutex> lm (mutex);
+				if (!error) {
+					error = std::current_exception ();
+				}
+			}
+
+			std::lock_guard<std::mutex> lm (mutex);
+			job.done = job.size;
+			--device->active;
+			condition.notify_all ();
+		}
+
+		std::lock_guard<std::mutex> lm (mutex);
+		++finished;
+		condition.notify_all ();
+	};
+
+	int const workers_count = max (1, min(threads, static_cast<int>(jobs.size())));
+	vector<std::thread> workers;
+	for (int i = 0; i < workers_count; ++i) {
+		workers.push_back (std::thread(work));
+	}
+
+	uintmax_t total = 0;
+	for (auto const& i: jobs) {
+		total += i.size;
+	}
+
+	std::unique_lock<std::mutex> lm (mutex);
+	while (true) {
+		auto const all_finished = condition.wait_for (lm, std::chrono::milliseconds(100), [&]() { return finished == workers_count; });
+		if (progress && total > 0) {
+			uintmax_t done = 0;
+			for (auto const& i: jobs) {
+				done += i.done;
+			}
+			lm.unlock ();
+			progress (float(done) / total);
+			lm.lock ();
+		}
+		if (all_finished) {
+			break;
+		}
+	}
+	lm.unlock ();
+
+	for (auto& i: workers) {
+		i.join ();
+	}
+
+	if (error) {
+		std::rethrow_exception (error);
+	}
+}
@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/hash_assets.h
+ *  @brief hash_assets function
+ */
+
+
+#ifndef LIBDCP_HASH_ASSETS_H
+#define LIBDCP_HASH_ASSETS_H
+
+
+#include <boost/function.hpp>
+#include <memory>
+#include <vector>
+
+
+namespace dcp {
+
+
+class Asset;
+
+
+/** @return Default number of files for hash_assets() to hash at once */
+int default_hash_threads ();
+
+
+/** Calculate the hashes of some assets' files, hashing several files at once.
+ *  After this has returned each asset's Asset::hash() will return immediately.
+ *
+ *  Files on the same spinning disk are hashed one at a time, since seeking between
+ *  them would be slower than reading them in turn; files on solid-state or network
+ *  storage are hashed in parallel, up to @p threads at once.
+ *
+ *  @param assets Assets to hash; any without files are skipped, and any whose hashes are already
+ *  known count as finished as soon as they are reached.
+ *  @param threads Maximum number of files to hash at once.
+ *  @param progress Called with the total progress (from 0 to 1); always called from the calling thread.
+ */
+void hash_assets (
+	std::vector<std::shared_ptr<const Asset>> assets,
+	int threads = default_hash_threads(),
+	boost::function<void (float)> progress = {}
+	);
+
+
+}
+
+
+#endif
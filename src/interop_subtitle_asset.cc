@@ -37,6 +37,7 @@
  */
 
 
+#include "asset_index.h"
 #include "compose.hpp"
 #include "dcp_assert.h"
 #include "font_asset.h"
@@ -52,6 +53,7 @@ LIBDCP_DISABLE_WARNINGS
 #include <libxml++/libxml++.h>
 LIBDCP_ENABLE_WARNINGS
 #include <boost/weak_ptr.hpp>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 
@@ -231,7 +233,7 @@ InteropSubtitleAsset::write (boost::filesystem::path p) const
  *  a list of font ID, load ID and data.
  */
 void
-InteropSubtitleAsset::resolve_fonts (vector<shared_ptr<Asset>> assets)
+InteropSubtitleAsset::resolve_fonts (vector<shared_ptr<Asset>> const& assets)
 {
 	for (auto i: assets) {
 		auto font = dynamic_pointer_cast<FontAsset> (i);
@@ -256,6 +258,26 @@ InteropSubtitleAsset::resolve_fonts (vector<shared_ptr<Asset>> assets)
 }
 
 
+/** As above, but finding each font by name in an index rather than looking through all the assets.
+ *  Fonts are added to _fonts in the order of the <LoadFont> nodes that ask for them.
+ */
+void
+InteropSubtitleAsset::resolve_fonts (AssetIndex const& assets)
+{
+	for (auto i: _load_font_nodes) {
+		auto got = std::find_if (_fonts.begin(), _fonts.end(), [i](Font const& font) {
+			return font.load_id == i->id;
+		});
+
+		if (got == _fonts.end()) {
+			if (auto font = assets.find_font(i->uri)) {
+				_fonts.push_back (Font(i->id, font->id(), font->file().get()));
+			}
+		}
+	}
+}
+
+
 void
 InteropSubtitleAsset::add_font_assets (vector<shared_ptr<Asset>>& assets)
 {
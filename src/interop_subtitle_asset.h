@@ -48,6 +48,7 @@
 namespace dcp {
 
 
+class AssetIndex;
 class InteropLoadFontNode;
 
 
@@ -80,7 +81,8 @@ public:
 	/** Write this content to an XML file with its fonts alongside */
 	void write (boost::filesystem::path path) const override;
 
-	void resolve_fonts (std::vector<std::shared_ptr<Asset>> assets);
+	void resolve_fonts (std::vector<std::shared_ptr<Asset>> const& assets);
+	void resolve_fonts (AssetIndex const& assets);
 	void add_font_assets (std::vector<std::shared_ptr<Asset>>& assets);
 	void set_font_file (std::string load_id, boost::filesystem::path file);
 
@@ -0,0 +1,253 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/j2k_encode_pipeline.cc
+ *  @brief J2KEncodePipeline class
+ */
+
+
+#include "compose.hpp"
+#include "dcp_assert.h"
+#include "exceptions.h"
+#include "j2k_encode_pipeline.h"
+#include "j2k_transcode.h"
+#include "openjpeg_image.h"
+#include "rgb_xyz.h"
+
+
+using std::max;
+using std::shared_ptr;
+using boost::function;
+using namespace dcp;
+
+
+/* J2KEncodePipeline is not available with OpenJPEG 1 */
+#ifndef LIBDCP_OPENJPEG1
+
+
+J2KEncodePipeline::J2KEncodePipeline (
+	shared_ptr<PictureAssetWriter> writer,
+	int threads,
+	int bandwidth,
+	int frames_per_second,
+	bool threed,
+	bool fourk,
+	int max_in_flight,
+	function<void (int64_t, FrameInfo)> frame_written
+	)
+	: _writer (writer)
+	, _bandwidth (bandwidth)
+	, _frames_per_second (frames_per_second)
+	, _threed (threed)
+	, _fourk (fourk)
+	, _max_in_flight (max_in_flight)
+	, _frame_written (frame_written)
+{
+	DCP_ASSERT (threads > 0);
+	DCP_ASSERT (max_in_flight > 0);
+
+	for (int i = 0; i < threads; ++i) {
+		_threads.push_back (std::thread(&J2KEncodePipeline::thread, this));
+	}
+}
+
+
+J2KEncodePipeline::~J2KEncodePipeline ()
+{
+	{
+		std::lock_guard<std::mutex> lm (_mutex);
+		_stop = true;
+	}
+
+	_encode_condition.notify_all ();
+	_written_condition.notify_all ();
+
+	for (auto& i: _threads) {
+		i.join ();
+	}
+}
+
+
+void
+J2KEncodePipeline::push (int64_t index, shared_ptr<const OpenJPEGImage> xyz)
+{
+	std::unique_lock<std::mutex> lm (_mutex);
+
+	_written_condition.wait (lm, [this, index]() {
+		return _error || index < _next_write + _max_in_flight;
+	});
+
+	rethrow ();
+
+	DCP_ASSERT (index >= _next_write);
+	DCP_ASSERT (_to_encode.find(index) == _to_encode.end());
+	DCP_ASSERT (_to_write.find(index) == _to_write.end());
+
+	_to_encode[index] = xyz;
+	_end = max (_end, index + 1);
+	_encode_condition.notify_one ();
+}
+
+
+void
+J2KEncodePipeline::push (int64_t index, uint8_t const * rgb, Size size, int stride, ColourConversion const& conversion)
+{
+	push (index, rgb_to_xyz(rgb, size, stride, conversion));
+}
+
+
+void
+J2KEncodePipeline::flush ()
+{
+	std::unique_lock<std::mutex> lm (_mutex);
+	_written_condition.wait (lm, [this]() {
+		/* With nothing waiting to be encoded, being encoded or being written, frame _next_write can only
+		   come from a push() which, as we are flushing, should not happen now.
+		*/
+		return _error || _next_write >= _end || (_to_encode.empty() && _encoding == 0 && !_writing);
+	});
+	rethrow ();
+
+	if (_next_write < _end) {
+		throw MiscError (String::compose("Frame %1 was never pushed to J2KEncodePipeline", _next_write));
+	}
+}
+
+
+/** Throw any error that has happened; must be called with _mutex held */
+void
+J2KEncodePipeline::rethrow ()
+{
+	if (_error) {
+		std::rethrow_exception (_error);
+	}
+}
+
+
+void
+J2KEncodePipeline::thread ()
+{
+	/* Each thread keeps its own encoder so that its parameters and output buffer are set up once */
+	J2KEncoder encoder (_bandwidth, _frames_per_second, _threed, _fourk);
+
+	std::unique_lock<std::mutex> lm (_mutex);
+
+	while (true) {
+		_encode_condition.wait (lm, [this]() {
+			return _stop || _error || !_to_encode.empty();
+		});
+
+		if (_stop || _error) {
+			return;
+		}
+
+		/* Encode the earliest frame first, as that is the one that the writer will want soonest */
+		auto const index = _to_encode.begin()->first;
+		auto xyz = _to_encode.begin()->second;
+		_to_encode.erase (_to_encode.begin());
+		++_encoding;
+
+		try {
+			lm.unlock ();
+			auto encoded = encoder.encode (xyz);
+			xyz.reset ();
+			lm.lock ();
+			--_encoding;
+			_to_write.insert (std::make_pair(index, encoded));
+			write_ready (lm);
+			/* Let flush() see that this frame is no longer being encoded, even if it could not be written yet */
+			_written_condition.notify_all ();
+		} catch (...) {
+			if (!lm.owns_lock()) {
+				lm.lock ();
+				--_encoding;
+			}
+			if (!_error) {
+				_error = std::current_exception ();
+			}
+			_encode_condition.notify_all ();
+			_written_condition.notify_all ();
+		}
+	}
+}
+
+
+/** Write any frames which are ready to be written, in order, unless another thread is already doing so.
+ *  Must be called with @p lock held; it is released while each frame is written.
+ */
+void
+J2KEncodePipeline::write_ready (std::unique_lock<std::mutex>& lock)
+{
+	if (_writing) {
+		/* The thread which is writing will pick up our frame when it gets to it */
+		return;
+	}
+
+	_writing = true;
+
+	try {
+		while (!_error && !_stop) {
+			auto const index = _next_write;
+			auto i = _to_write.find (index);
+			if (i == _to_write.end()) {
+				break;
+			}
+
+			auto data = i->second;
+			_to_write.erase (i);
+
+			lock.unlock ();
+			auto const info = _writer->write (data.data(), data.size());
+			if (_frame_written) {
+				_frame_written (index, info);
+			}
+			lock.lock ();
+
+			++_next_write;
+			_written_condition.notify_all ();
+		}
+	} catch (...) {
+		if (!lock.owns_lock()) {
+			lock.lock ();
+		}
+		_writing = false;
+		throw;
+	}
+
+	_writing = false;
+}
+
+
+#endif
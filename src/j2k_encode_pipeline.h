@@ -0,0 +1,176 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/j2k_encode_pipeline.h
+ *  @brief J2KEncodePipeline class
+ */
+
+
+#ifndef LIBDCP_J2K_ENCODE_PIPELINE_H
+#define LIBDCP_J2K_ENCODE_PIPELINE_H
+
+
+#include "array_data.h"
+#include "picture_asset_writer.h"
+#include "types.h"
+#include <boost/function.hpp>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/* This uses J2KEncoder, which needs OpenJPEG 2 */
+#ifndef LIBDCP_OPENJPEG1
+
+
+namespace dcp {
+
+
+class ColourConversion;
+class OpenJPEGImage;
+
+
+/** @class J2KEncodePipeline
+ *  @brief Encode frames to JPEG2000 on several threads and write them, in order, to a PictureAssetWriter.
+ *
+ *  Frames can be pushed from any thread and in any order; each is given an index, and they are written
+ *  in the order of those indices, starting at 0.  For a stereoscopic asset the left and right eyes of frame
+ *  N should be given indices 2N and 2N+1.
+ *
+ *  Only frames whose indices are less than max_in_flight ahead of the next frame to be written are
+ *  accepted; push() blocks for any others until the writing has caught up.  This limits the memory used
+ *  by frames which are waiting to be encoded or written, and means that the frame which is needed next
+ *  can always be pushed.
+ */
+class J2KEncodePipeline
+{
+public:
+	/** @param writer Writer to write encoded frames to.
+	 *  @param threads Number of encoding threads.
+	 *  @param bandwidth Bandwidth to pass to compress_j2k().
+	 *  @param frames_per_second Frame rate to pass to compress_j2k().
+	 *  @param threed true if the frames are for a 3D asset.
+	 *  @param fourk true if the frames are 4K.
+	 *  @param max_in_flight Maximum number of frames that can be waiting to be encoded or written.
+	 *  @param frame_written Called, in order, with the index of each frame and the FrameInfo that the
+	 *  writer gave for it.  This is called from one of the encoding threads.
+	 */
+	J2KEncodePipeline (
+		std::shared_ptr<PictureAssetWriter> writer,
+		int threads,
+		int bandwidth,
+		int frames_per_second,
+		bool threed,
+		bool fourk,
+		int max_in_flight,
+		boost::function<void (int64_t, FrameInfo)> frame_written = {}
+		);
+
+	~J2KEncodePipeline ();
+
+	J2KEncodePipeline (J2KEncodePipeline const&) = delete;
+	J2KEncodePipeline& operator= (J2KEncodePipeline const&) = delete;
+
+	/** Add an XYZ frame to be encoded.  Note that compress_j2k() overwrites some of the image's data,
+	 *  so it should not be used again.
+	 *  @param index Index of the frame.
+	 */
+	void push (int64_t index, std::shared_ptr<const OpenJPEGImage> xyz);
+
+	/** Add an RGB frame to be encoded; it is converted to XYZ on the calling thread.
+	 *  @param index Index of the frame.
+	 *  @param rgb RGB data, in the format taken by rgb_to_xyz().
+	 *  @param size Size of the image in pixels.
+	 *  @param stride Stride of the RGB data in bytes.
+	 *  @param conversion Colour conversion to use.
+	 */
+	void push (int64_t index, uint8_t const * rgb, Size size, int stride, ColourConversion const& conversion);
+
+	/** Wait until every frame up to the highest index that has been pushed has been encoded and written.
+	 *  This should only be called once every call to push() has returned.  If anything went wrong while
+	 *  encoding or writing, the exception is thrown from here (and from any later call to push()).  If some
+	 *  index below the highest was never pushed, MiscError is thrown once everything before it is written.
+	 */
+	void flush ();
+
+private:
+	void thread ();
+	void write_ready (std::unique_lock<std::mutex>& lock);
+	void rethrow ();
+
+	std::shared_ptr<PictureAssetWriter> _writer;
+	int _bandwidth;
+	int _frames_per_second;
+	bool _threed;
+	bool _fourk;
+	int _max_in_flight;
+	boost::function<void (int64_t, FrameInfo)> _frame_written;
+
+	std::vector<std::thread> _threads;
+
+	/** mutex for everything below */
+	std::mutex _mutex;
+	/** signalled when there is a new frame to encode, or we are stopping */
+	std::condition_variable _encode_condition;
+	/** signalled when a frame has been written, or something has gone wrong */
+	std::condition_variable _written_condition;
+	/** frames waiting to be encoded, by index */
+	std::map<int64_t, std::shared_ptr<const OpenJPEGImage>> _to_encode;
+	/** frames waiting to be written, by index */
+	std::map<int64_t, ArrayData> _to_write;
+	/** number of frames which are being encoded now */
+	int _encoding = 0;
+	/** index of the next frame to write */
+	int64_t _next_write = 0;
+	/** one more than the highest index that has been pushed */
+	int64_t _end = 0;
+	/** true if some thread is writing frames */
+	bool _writing = false;
+	bool _stop = false;
+	std::exception_ptr _error;
+};
+
+
+}
+
+
+#endif
+
+
+#endif
@@ -44,10 +44,13 @@
 #include "dcp_assert.h"
 #include "compose.hpp"
 #include <openjpeg.h>
+#include <climits>
 #include <cmath>
 #include <iostream>
+#include <mutex>
 
 
+using std::max;
 using std::min;
 using std::pow;
 using std::string;
@@ -110,25 +113,128 @@ read_free_function (void* data)
 }
 
 
-static void
-decompress_error_callback (char const * msg, void *)
+/** Somewhere for OpenJPEG's error handler to keep what it is told.  We can't throw from the handler
+ *  itself as it may be called from one of OpenJPEG's threads, and even when it isn't the exception
+ *  would skip the destruction of our codec, stream and image.
+ */
+class OpenJPEGErrors
 {
-	throw J2KDecompressionError (msg);
+public:
+	static void handler (char const * msg, void* data)
+	{
+		auto errors = reinterpret_cast<OpenJPEGErrors*>(data);
+		std::lock_guard<std::mutex> lm (errors->_mutex);
+		if (!errors->_first) {
+			errors->_first = msg;
+		}
+	}
+
+	bool any () const {
+		std::lock_guard<std::mutex> lm (_mutex);
+		return static_cast<bool>(_first);
+	}
+
+	/** Throw an E with the first error that was reported, if there was one */
+	template <class E>
+	void rethrow () const
+	{
+		std::lock_guard<std::mutex> lm (_mutex);
+		if (_first) {
+			boost::throw_exception (E(*_first));
+		}
+	}
+
+private:
+	mutable std::mutex _mutex;
+	boost::optional<string> _first;
+};
+
+
+shared_ptr<dcp::OpenJPEGImage>
+dcp::decompress_j2k (uint8_t const * data, int64_t size, int reduce)
+{
+	return J2KDecoder(reduce).decode(data, size);
 }
 
 
-static void
-compress_error_callback (char const * msg, void *)
+J2KDecoder::J2KDecoder (int reduce, int threads)
 {
-	throw MiscError (msg);
+	_parameters = new opj_dparameters_t;
+	opj_set_default_decoder_parameters (_parameters);
+	set_reduce (reduce);
+	set_threads (threads);
 }
 
 
-shared_ptr<dcp::OpenJPEGImage>
-dcp::decompress_j2k (uint8_t const * data, int64_t size, int reduce)
+J2KDecoder::~J2KDecoder ()
+{
+	delete _parameters;
+}
+
+
+int
+J2KDecoder::reduce () const
+{
+	return _parameters->cp_reduce;
+}
+
+
+void
+J2KDecoder::set_reduce (int reduce)
 {
 	DCP_ASSERT (reduce >= 0);
+	_parameters->cp_reduce = reduce;
+}
+
 
+void
+J2KDecoder::set_threads (int threads)
+{
+	DCP_ASSERT (threads >= 1);
+	_threads = threads;
+}
+
+
+void
+J2KDecoder::set_area (int x, int y, Size size)
+{
+	DCP_ASSERT (x >= 0 && y >= 0 && size.width > 0 && size.height > 0);
+	_area = Area{x, y, size};
+}
+
+
+void
+J2KDecoder::unset_area ()
+{
+	_area = boost::none;
+}
+
+
+int
+J2KDecoder::layers () const
+{
+	return _parameters->cp_layer;
+}
+
+
+void
+J2KDecoder::set_layers (int layers)
+{
+	DCP_ASSERT (layers >= 0);
+	_parameters->cp_layer = layers;
+}
+
+
+shared_ptr<OpenJPEGImage>
+J2KDecoder::decode (Data const& data)
+{
+	return decode (data.data(), data.size());
+}
+
+
+shared_ptr<OpenJPEGImage>
+J2KDecoder::decode (uint8_t const * data, int64_t size)
+{
 	uint8_t const jp2_magic[] = {
 		0x00,
 		0x00,
@@ -149,17 +255,23 @@ dcp::decompress_j2k (uint8_t const * data, int64_t size, int reduce)
 	if (!decoder) {
 		boost::throw_exception (ReadError ("could not create JPEG2000 decompresser"));
 	}
-	opj_dparameters_t parameters;
-	opj_set_default_decoder_parameters (&parameters);
-	parameters.cp_reduce = reduce;
-	opj_setup_decoder (decoder, &parameters);
+	opj_setup_decoder (decoder, _parameters);
+
+#if OPJ_VERSION_MAJOR > 2 || (OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 2)
+	if (_threads > 1) {
+		/* This will fail, leaving us with one thread, if this OpenJPEG cannot decode with more */
+		opj_codec_set_threads (decoder, _threads);
+	}
+#endif
 
 	auto stream = opj_stream_default_create (OPJ_TRUE);
 	if (!stream) {
+		opj_destroy_codec (decoder);
 		throw MiscError ("could not create JPEG2000 stream");
 	}
 
-	opj_set_error_handler(decoder, decompress_error_callback, 00);
+	OpenJPEGErrors errors;
+	opj_set_error_handler (decoder, OpenJPEGErrors::handler, &errors);
 
 	opj_stream_set_read_function (stream, read_function);
 	auto buffer = new ReadBuffer (data, size);
@@ -167,10 +279,18 @@ dcp::decompress_j2k (uint8_t const * data, int64_t size, int reduce)
 	opj_stream_set_user_data_length (stream, size);
 
 	opj_image_t* image = 0;
-	opj_read_header (stream, decoder, &image);
-	if (opj_decode (decoder, stream, image) == OPJ_FALSE) {
+	auto ok = opj_read_header(stream, decoder, &image);
+	if (ok && _area) {
+		ok = opj_set_decode_area(decoder, image, _area->x, _area->y, _area->x + _area->size.width, _area->y + _area->size.height);
+	}
+	/* OpenJPEG may report an error without failing, and we have always treated that as a failure */
+	if (!ok || opj_decode(decoder, stream, image) == OPJ_FALSE || errors.any()) {
 		opj_destroy_codec (decoder);
 		opj_stream_destroy (stream);
+		if (image) {
+			opj_image_destroy (image);
+		}
+		errors.rethrow<J2KDecompressionError>();
 		if (format == OPJ_CODEC_J2K) {
 			boost::throw_exception (ReadError (String::compose ("could not decode JPEG2000 codestream of %1 bytes.", size)));
 		} else {
@@ -181,8 +301,20 @@ dcp::decompress_j2k (uint8_t const * data, int64_t size, int reduce)
 	opj_destroy_codec (decoder);
 	opj_stream_destroy (stream);
 
-	image->x1 = rint (float(image->x1) / pow (2.0f, reduce));
-	image->y1 = rint (float(image->y1) / pow (2.0f, reduce));
+	if (_area) {
+		/* OpenJPEG leaves the image positioned where the area was in the full frame; OpenJPEGImage
+		 * expects it at (0, 0) and sized in reduced pixels, so move it there.
+		 */
+		image->x0 = image->y0 = 0;
+		image->x1 = image->comps[0].w;
+		image->y1 = image->comps[0].h;
+		for (auto i = 0U; i < image->numcomps; ++i) {
+			image->comps[i].x0 = image->comps[i].y0 = 0;
+		}
+	} else {
+		image->x1 = rint (float(image->x1) / pow (2.0f, reduce()));
+		image->y1 = rint (float(image->y1) / pow (2.0f, reduce()));
+	}
 	return shared_ptr<OpenJPEGImage> (new OpenJPEGImage (image));
 }
 
@@ -219,26 +351,30 @@ dcp::decompress_j2k (uint8_t* data, int64_t size, int reduce)
 
 #ifdef LIBDCP_OPENJPEG2
 
+/** Destination for an encoded codestream which writes into a given buffer, replacing that buffer with
+ *  a larger one if the codestream does not fit.
+ */
 class WriteBuffer
 {
 public:
-/* XXX: is there a better strategy for this? */
-#define MAX_J2K_SIZE (1024 * 1024 * 2)
-	WriteBuffer ()
-		: _data (shared_array<uint8_t>(new uint8_t[MAX_J2K_SIZE]), MAX_J2K_SIZE)
-		, _offset (0)
-	{
-		_data.set_size (0);
-	}
+	WriteBuffer (shared_array<uint8_t> data, OPJ_SIZE_T capacity)
+		: _data (data)
+		, _capacity (capacity)
+	{}
 
 	OPJ_SIZE_T write (void* buffer, OPJ_SIZE_T nb_bytes)
 	{
-		DCP_ASSERT ((_offset + nb_bytes) < MAX_J2K_SIZE);
-		memcpy (_data.data() + _offset, buffer, nb_bytes);
-		_offset += nb_bytes;
-		if (_offset > OPJ_SIZE_T(_data.size())) {
-			_data.set_size (_offset);
+		if ((_offset + nb_bytes) > _capacity) {
+			auto const capacity = max (_capacity * 2, _offset + nb_bytes);
+			DCP_ASSERT (capacity <= OPJ_SIZE_T(INT_MAX));
+			shared_array<uint8_t> data (new uint8_t[capacity]);
+			memcpy (data.get(), _data.get(), _size);
+			_data = data;
+			_capacity = capacity;
 		}
+		memcpy (_data.get() + _offset, buffer, nb_bytes);
+		_offset += nb_bytes;
+		_size = max (_size, _offset);
 		return nb_bytes;
 	}
 
@@ -248,14 +384,23 @@ public:
 		return OPJ_TRUE;
 	}
 
-	ArrayData data () const
-	{
+	shared_array<uint8_t> data () const {
 		return _data;
 	}
 
+	OPJ_SIZE_T capacity () const {
+		return _capacity;
+	}
+
+	OPJ_SIZE_T size () const {
+		return _size;
+	}
+
 private:
-	ArrayData _data;
-	OPJ_SIZE_T _offset;
+	shared_array<uint8_t> _data;
+	OPJ_SIZE_T _capacity;
+	OPJ_SIZE_T _offset = 0;
+	OPJ_SIZE_T _size = 0;
 };
 
 
@@ -266,13 +411,6 @@ write_function (void* buffer, OPJ_SIZE_T nb_bytes, void* data)
 }
 
 
-static void
-write_free_function (void* data)
-{
-	delete reinterpret_cast<WriteBuffer*>(data);
-}
-
-
 static OPJ_BOOL
 seek_function (OPJ_OFF_T nb_bytes, void* data)
 {
@@ -284,58 +422,102 @@ seek_function (OPJ_OFF_T nb_bytes, void* data)
 ArrayData
 dcp::compress_j2k (shared_ptr<const OpenJPEGImage> xyz, int bandwidth, int frames_per_second, bool threed, bool fourk, string comment)
 {
-	/* get a J2K compressor handle */
-	auto encoder = opj_create_compress (OPJ_CODEC_J2K);
-	if (encoder == nullptr) {
-		throw MiscError ("could not create JPEG2000 encoder");
-	}
+	return J2KEncoder(bandwidth, frames_per_second, threed, fourk, comment).encode(xyz);
+}
 
+
+J2KEncoder::J2KEncoder (int bandwidth, int frames_per_second, bool threed, bool fourk, string comment, int threads)
+	: _threads (threads)
+{
 	if (comment.empty()) {
 		/* asdcplib complains with "Illegal data size" when reading frames encoded with an empty comment */
 		throw MiscError("compress_j2k comment can not be an empty string");
 	}
 
-	opj_set_error_handler (encoder, compress_error_callback, 0);
+	_parameters = new opj_cparameters_t;
 
 	/* Set encoding parameters to default values */
-	opj_cparameters_t parameters;
-	opj_set_default_encoder_parameters (&parameters);
+	opj_set_default_encoder_parameters (_parameters);
 	if (fourk) {
-		parameters.numresolution = 7;
+		_parameters->numresolution = 7;
 	}
-	parameters.rsiz = fourk ? OPJ_PROFILE_CINEMA_4K : OPJ_PROFILE_CINEMA_2K;
-	parameters.cp_comment = strdup (comment.c_str());
+	_parameters->rsiz = fourk ? OPJ_PROFILE_CINEMA_4K : OPJ_PROFILE_CINEMA_2K;
+	_parameters->cp_comment = strdup (comment.c_str());
 
 	/* set max image */
-	parameters.max_cs_size = (bandwidth / 8) / frames_per_second;
+	_parameters->max_cs_size = (bandwidth / 8) / frames_per_second;
 	if (threed) {
 		/* In 3D we have only half the normal bandwidth per eye */
-		parameters.max_cs_size /= 2;
+		_parameters->max_cs_size /= 2;
 	}
-	parameters.max_comp_size = parameters.max_cs_size / 1.25;
-	parameters.tcp_numlayers = 1;
-	parameters.tcp_mct = 1;
-	parameters.numgbits = fourk ? 2 : 1;
+	_parameters->max_comp_size = _parameters->max_cs_size / 1.25;
+	_parameters->tcp_numlayers = 1;
+	_parameters->tcp_mct = 1;
+	_parameters->numgbits = fourk ? 2 : 1;
+
+	/* Start with enough space for a frame which uses all its bandwidth, plus some for markers; the
+	 * buffer will grow if this turns out not to be enough.
+	 */
+	_capacity = max (_parameters->max_cs_size, 0) + 65536;
+}
 
-	/* Setup the encoder parameters using the current image and user parameters */
+
+J2KEncoder::~J2KEncoder ()
+{
+	free (_parameters->cp_comment);
+	delete _parameters;
+}
+
+
+ArrayData
+J2KEncoder::encode (shared_ptr<const OpenJPEGImage> xyz)
+{
+	/* get a J2K compressor handle */
+	auto encoder = opj_create_compress (OPJ_CODEC_J2K);
+	if (encoder == nullptr) {
+		throw MiscError ("could not create JPEG2000 encoder");
+	}
+
+	OpenJPEGErrors errors;
+	opj_set_error_handler (encoder, OpenJPEGErrors::handler, &errors);
+
+	/* Setup the encoder parameters using the current image and our parameters; opj_setup_encoder
+	 * may change the parameters it is given to suit the image, so give it a copy.
+	 */
+	auto parameters = *_parameters;
 	opj_setup_encoder (encoder, &parameters, xyz->opj_image());
+	if (errors.any()) {
+		opj_destroy_codec (encoder);
+		errors.rethrow<MiscError>();
+	}
+
+#if OPJ_VERSION_MAJOR > 2 || (OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 2)
+	if (_threads > 1) {
+		/* This will fail, leaving us with one thread, if this OpenJPEG cannot encode with more */
+		opj_codec_set_threads (encoder, _threads);
+	}
+#endif
 
 	auto stream = opj_stream_default_create (OPJ_FALSE);
 	if (!stream) {
 		opj_destroy_codec (encoder);
-		free (parameters.cp_comment);
 		throw MiscError ("could not create JPEG2000 stream");
 	}
 
+	if (!_buffer || _buffer.use_count() > 1) {
+		/* This is the first frame, or someone is still using the last frame's codestream */
+		_buffer.reset (new uint8_t[_capacity]);
+	}
+
 	opj_stream_set_write_function (stream, write_function);
 	opj_stream_set_seek_function (stream, seek_function);
-	WriteBuffer* buffer = new WriteBuffer ();
-	opj_stream_set_user_data (stream, buffer, write_free_function);
+	WriteBuffer buffer (_buffer, _capacity);
+	opj_stream_set_user_data (stream, &buffer, nullptr);
 
 	if (!opj_start_compress (encoder, xyz->opj_image(), stream)) {
 		opj_stream_destroy (stream);
 		opj_destroy_codec (encoder);
-		free (parameters.cp_comment);
+		errors.rethrow<MiscError>();
 		if ((errno & 0x61500) == 0x61500) {
 			/* We've had one of the magic error codes from our patched openjpeg */
 			boost::throw_exception (StartCompressionError (errno & 0xff));
@@ -347,24 +529,28 @@ dcp::compress_j2k (shared_ptr<const OpenJPEGImage> xyz, int bandwidth, int frame
 	if (!opj_encode (encoder, stream)) {
 		opj_stream_destroy (stream);
 		opj_destroy_codec (encoder);
-		free (parameters.cp_comment);
+		errors.rethrow<MiscError>();
 		throw MiscError ("JPEG2000 encoding failed");
 	}
 
 	if (!opj_end_compress (encoder, stream)) {
 		opj_stream_destroy (stream);
 		opj_destroy_codec (encoder);
-		free (parameters.cp_comment);
+		errors.rethrow<MiscError>();
 		throw MiscError ("could not end JPEG2000 encoding");
 	}
 
-	ArrayData enc (buffer->data ());
-
 	opj_stream_destroy (stream);
 	opj_destroy_codec (encoder);
-	free (parameters.cp_comment);
 
-	return enc;
+	/* OpenJPEG may report an error without failing, and we have always treated that as a failure */
+	errors.rethrow<MiscError>();
+
+	/* The buffer may have been replaced with a bigger one, which we will keep for next time */
+	_buffer = buffer.data ();
+	_capacity = buffer.capacity ();
+
+	return ArrayData (_buffer, buffer.size());
 }
 
 #endif
@@ -38,10 +38,17 @@
 
 
 #include "array_data.h"
+#include "types.h"
+#include <boost/optional.hpp>
+#include <boost/shared_array.hpp>
 #include <memory>
 #include <stdint.h>
 
 
+struct opj_cparameters;
+struct opj_dparameters;
+
+
 namespace dcp {
 
 
@@ -62,10 +69,124 @@ extern std::shared_ptr<OpenJPEGImage> decompress_j2k (uint8_t const * data, int6
 extern std::shared_ptr<OpenJPEGImage> decompress_j2k (Data const& data, int reduce);
 extern std::shared_ptr<OpenJPEGImage> decompress_j2k (std::shared_ptr<const Data> data, int reduce);
 
+
+#ifndef LIBDCP_OPENJPEG1
+
+/** @class J2KDecoder
+ *  @brief A JPEG2000 decoder which keeps its parameters from one frame to the next, and which
+ *  can ask OpenJPEG to decode each frame using several threads.
+ *
+ *  A J2KDecoder may only be used by one thread at a time.  It is not available when libdcp is
+ *  built with OpenJPEG 1.
+ */
+class J2KDecoder
+{
+public:
+	/** @param reduce A power of 2 by which to reduce the size of decoded images, as for decompress_j2k().
+	 *  @param threads Number of threads that OpenJPEG should use to decode each frame.  This is ignored
+	 *  if the OpenJPEG that we are built with cannot decode with more than one thread.
+	 */
+	explicit J2KDecoder (int reduce = 0, int threads = 1);
+	~J2KDecoder ();
+
+	J2KDecoder (J2KDecoder const&) = delete;
+	J2KDecoder& operator= (J2KDecoder const&) = delete;
+
+	std::shared_ptr<OpenJPEGImage> decode (uint8_t const * data, int64_t size);
+	std::shared_ptr<OpenJPEGImage> decode (Data const& data);
+
+	int reduce () const;
+	void set_reduce (int reduce);
+
+	int threads () const {
+		return _threads;
+	}
+
+	void set_threads (int threads);
+
+	/** Decode only part of each frame, which is much quicker than decoding the whole thing.
+	 *  The decoded image will be the given area, reduced as set by set_reduce().
+	 *  @param x x position of the area's top-left corner, in pixels of the full-size frame.
+	 *  @param y y position of the area's top-left corner, in pixels of the full-size frame.
+	 *  @param size Size of the area, in pixels of the full-size frame.
+	 */
+	void set_area (int x, int y, Size size);
+
+	/** Go back to decoding the whole of each frame */
+	void unset_area ();
+
+	/** @return Maximum number of quality layers to decode, or 0 to decode all of them */
+	int layers () const;
+
+	/** Set the maximum number of quality layers to decode; decoding fewer layers gives
+	 *  a coarser image more quickly.
+	 *  @param layers Number of layers, or 0 to decode all of them.
+	 */
+	void set_layers (int layers);
+
+private:
+	struct Area
+	{
+		int x;
+		int y;
+		Size size;
+	};
+
+	opj_dparameters* _parameters = nullptr;
+	int _threads = 1;
+	boost::optional<Area> _area;
+};
+
+#endif
+
+
 /** @xyz Picture to compress.  Parts of xyz's data WILL BE OVERWRITTEN by libopenjpeg so xyz cannot be re-used
  *  after this call; see opj_j2k_encode where if l_reuse_data is false it will set l_tilec->data = l_img_comp->data.
  */
 extern ArrayData compress_j2k (std::shared_ptr<const OpenJPEGImage>, int bandwith, int frames_per_second, bool threed, bool fourk, std::string comment = "libdcp");
 
 
+#ifndef LIBDCP_OPENJPEG1
+
+/** @class J2KEncoder
+ *  @brief A JPEG2000 encoder which keeps its parameters and output buffer from one frame to the next.
+ *
+ *  Encoding a sequence of frames with one of these avoids setting up the parameters and allocating
+ *  a new output buffer for every frame, as compress_j2k() must.  A J2KEncoder may only be used by one
+ *  thread at a time; to encode in parallel, make one per thread.  It is not available when libdcp is
+ *  built with OpenJPEG 1.
+ */
+class J2KEncoder
+{
+public:
+	/** @param bandwidth Bandwidth in bits per second.
+	 *  @param frames_per_second Frame rate.
+	 *  @param threed true if the frames are for a 3D asset, in which case each eye gets half the bandwidth.
+	 *  @param fourk true if the frames are 4K.
+	 *  @param comment Comment to write into each codestream; must not be empty.
+	 *  @param threads Number of threads that OpenJPEG should use to encode each frame.  This is ignored
+	 *  if the OpenJPEG that we are built with cannot encode with more than one thread.
+	 */
+	J2KEncoder (int bandwidth, int frames_per_second, bool threed, bool fourk, std::string comment = "libdcp", int threads = 1);
+	~J2KEncoder ();
+
+	J2KEncoder (J2KEncoder const&) = delete;
+	J2KEncoder& operator= (J2KEncoder const&) = delete;
+
+	/** @param xyz Picture to compress; as with compress_j2k(), parts of its data will be overwritten.
+	 *  @return JPEG2000 codestream.  This shares its memory with the encoder, which will re-use that memory
+	 *  for a later frame once the returned ArrayData and any copies of it have been destroyed.
+	 */
+	ArrayData encode (std::shared_ptr<const OpenJPEGImage> xyz);
+
+private:
+	opj_cparameters* _parameters = nullptr;
+	int _threads = 1;
+	boost::shared_array<uint8_t> _buffer;
+	int _capacity = 0;
+};
+
+#endif
+
+
 }
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/lazy_asset.cc
+ *  @brief LazyAsset class.
+ */
+
+
+#include "asset.h"
+#include "dcp_assert.h"
+#include "exceptions.h"
+#include "lazy_asset.h"
+#include "util.h"
+
+
+using std::function;
+using std::shared_ptr;
+using std::string;
+using namespace dcp;
+
+
+LazyAsset::LazyAsset (string id, function<shared_ptr<Asset> ()> load)
+	: _id (id)
+	, _load (load)
+{
+
+}
+
+
+shared_ptr<Asset>
+LazyAsset::get () const
+{
+	std::lock_guard<std::mutex> lm (_mutex);
+	if (!_asset) {
+		auto asset = _load ();
+		DCP_ASSERT (asset);
+		/* We were found by the ID given in the ASSETMAP, but if the asset was made straight
+		   away it would be found by the ID in its own file; if those differ the asset is not
+		   the one that was asked for.
+		*/
+		if (!ids_equal(asset->id(), _id)) {
+			throw UnresolvedRefError (_id);
+		}
+		_asset = asset;
+	}
+	return _asset;
+}
+
+
+bool
+LazyAsset::loaded () const
+{
+	std::lock_guard<std::mutex> lm (_mutex);
+	return static_cast<bool>(_asset);
+}
@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/lazy_asset.h
+ *  @brief LazyAsset class.
+ */
+
+
+#ifndef LIBDCP_LAZY_ASSET_H
+#define LIBDCP_LAZY_ASSET_H
+
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+namespace dcp {
+
+
+class Asset;
+
+
+/** @class LazyAsset
+ *  @brief An asset which is not made until it is first needed.
+ *
+ *  DCP::read() uses these in its lazy mode so that asset files are only opened
+ *  and parsed when something asks for their contents.
+ */
+class LazyAsset
+{
+public:
+	/** @param id ID of the asset.
+	 *  @param load Function to make the asset; it will be called at most once, unless it throws.
+	 */
+	LazyAsset (std::string id, std::function<std::shared_ptr<Asset> ()> load);
+
+	LazyAsset (LazyAsset const&) = delete;
+	LazyAsset& operator= (LazyAsset const&) = delete;
+
+	std::string id () const {
+		return _id;
+	}
+
+	/** @return The asset, which is made if this is the first time that it has been asked for.
+	 *  Any exception thrown when making it is passed on, and the next call will try again.
+	 *  If the asset that is made has a different ID to this LazyAsset an UnresolvedRefError
+	 *  is thrown.  This may be called from any thread.
+	 */
+	std::shared_ptr<Asset> get () const;
+
+	/** @return true if the asset has been made */
+	bool loaded () const;
+
+private:
+	std::string _id;
+	std::function<std::shared_ptr<Asset> ()> _load;
+	mutable std::mutex _mutex;
+	mutable std::shared_ptr<Asset> _asset;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,134 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/mapped_essence.cc
+ *  @brief MappedEssence class.
+ */
+
+
+#include "compose.hpp"
+#include "exceptions.h"
+#include "frame_index.h"
+#include "mapped_essence.h"
+#include "mapped_file.h"
+
+
+using std::shared_ptr;
+using namespace dcp;
+
+
+MappedEssence::MappedEssence (shared_ptr<MappedFile> file, shared_ptr<const FrameIndex> index)
+	: _file (file)
+	, _index (index)
+{
+
+}
+
+
+shared_ptr<const MappedEssence>
+MappedEssence::open (boost::filesystem::path mxf)
+{
+#ifdef LIBDCP_WINDOWS
+	/* MappedFile would read the whole MXF into memory here */
+	return {};
+#else
+	auto index = FrameIndex::load (mxf);
+	if (!index) {
+		return {};
+	}
+
+	shared_ptr<MappedFile> file;
+	try {
+		file = std::make_shared<MappedFile>(mxf);
+	} catch (FileError &) {
+		/* Probably too big for our address space; the caller can read frames in the usual way */
+		return {};
+	}
+
+	/* Can't use make_shared here as the constructor is private */
+	return shared_ptr<const MappedEssence> (new MappedEssence(file, index));
+#endif
+}
+
+
+int64_t
+MappedEssence::size () const
+{
+	return _index->size ();
+}
+
+
+MappedEssence::Span
+MappedEssence::get (int64_t n) const
+{
+	if (n < 0 || n >= _index->size()) {
+		boost::throw_exception (ReadError(String::compose("could not read video frame %1 (there are only %2 in the index)", n, _index->size())));
+	}
+
+	auto const& entry = (*_index)[n];
+
+	/* Check that the entry points to a KLV packet whose value is the whole codestream: a 16-byte key,
+	   a BER length and then the data.
+	*/
+	int const key_length = 16;
+	auto bad = [n]() {
+		boost::throw_exception (ReadError(String::compose("frame index entry %1 does not match its MXF", n)));
+	};
+
+	if (entry.offset > _file->size() || entry.size > _file->size() - entry.offset || entry.size < key_length + 1) {
+		bad ();
+	}
+
+	auto const klv = _file->data() + entry.offset;
+	uint64_t length = klv[key_length];
+	int header = key_length + 1;
+	if (length & 0x80) {
+		int const bytes = length & 0x7f;
+		if (bytes > 8 || header + bytes > static_cast<int>(entry.size)) {
+			bad ();
+		}
+		length = 0;
+		for (int i = 0; i < bytes; ++i) {
+			length = (length << 8) | klv[header + i];
+		}
+		header += bytes;
+	}
+
+	if (length != entry.essence_size || header + length != entry.size) {
+		bad ();
+	}
+
+	return { klv + header, static_cast<int>(entry.essence_size) };
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/mapped_essence.h
+ *  @brief MappedEssence class.
+ */
+
+
+#ifndef LIBDCP_MAPPED_ESSENCE_H
+#define LIBDCP_MAPPED_ESSENCE_H
+
+
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <stdint.h>
+
+
+namespace dcp {
+
+
+class FrameIndex;
+class MappedFile;
+
+
+/** @class MappedEssence
+ *  @brief The unencrypted picture essence of a MXF, mapped into memory so that frames
+ *  can be used without copying them.
+ *
+ *  This needs the MXF's frame index sidecar (see FrameIndex) to find where each frame is.
+ */
+class MappedEssence
+{
+public:
+	MappedEssence (MappedEssence const&) = delete;
+	MappedEssence& operator= (MappedEssence const&) = delete;
+
+	/** @param mxf Unencrypted picture MXF.
+	 *  @return Mapped essence, or nullptr if the MXF has no up-to-date frame index, or it
+	 *  cannot be mapped (for example because this OS does not support mapping).
+	 */
+	static std::shared_ptr<const MappedEssence> open (boost::filesystem::path mxf);
+
+	struct Span
+	{
+		uint8_t const * data;
+		int size;
+	};
+
+	/** @param n Frame index entry; for stereoscopic assets there are two entries per frame,
+	 *  left eye then right eye.
+	 *  @return The entry's JPEG2000 codestream, which stays valid as long as this object does.
+	 */
+	Span get (int64_t n) const;
+
+	/** @return Number of frame index entries */
+	int64_t size () const;
+
+private:
+	MappedEssence (std::shared_ptr<MappedFile> file, std::shared_ptr<const FrameIndex> index);
+
+	std::shared_ptr<MappedFile> _file;
+	std::shared_ptr<const FrameIndex> _index;
+};
+
+
+}
+
+
+#endif
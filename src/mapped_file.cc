@@ -0,0 +1,115 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/mapped_file.cc
+ *  @brief MappedFile class.
+ */
+
+
+#include "exceptions.h"
+#include "mapped_file.h"
+#include "util.h"
+#include <cerrno>
+#include <cstdio>
+#ifndef LIBDCP_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+using namespace dcp;
+
+
+MappedFile::MappedFile (boost::filesystem::path file)
+{
+#ifdef LIBDCP_WINDOWS
+	auto f = fopen_boost (file, "rb");
+	if (!f) {
+		boost::throw_exception (FileError("could not open file", file, errno));
+	}
+	_copy.resize (boost::filesystem::file_size(file));
+	if (!_copy.empty() && fread(_copy.data(), 1, _copy.size(), f) != _copy.size()) {
+		fclose (f);
+		boost::throw_exception (FileError("could not read file", file, -1));
+	}
+	fclose (f);
+	_data = _copy.data();
+	_size = _copy.size();
+#else
+	auto fd = open (file.string().c_str(), O_RDONLY);
+	if (fd < 0) {
+		boost::throw_exception (FileError("could not open file", file, errno));
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		auto const e = errno;
+		close (fd);
+		boost::throw_exception (FileError("could not read file", file, e));
+	}
+
+	if (static_cast<uintmax_t>(st.st_size) > SIZE_MAX) {
+		close (fd);
+		boost::throw_exception (FileError("file is too big to map", file, -1));
+	}
+
+	_size = st.st_size;
+	if (_size > 0) {
+		auto data = mmap (nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			auto const e = errno;
+			close (fd);
+			boost::throw_exception (FileError("could not map file", file, e));
+		}
+		_data = reinterpret_cast<uint8_t const *>(data);
+		_mapped = true;
+	}
+
+	/* The mapping stays valid after the file is closed */
+	close (fd);
+#endif
+}
+
+
+MappedFile::~MappedFile ()
+{
+#ifndef LIBDCP_WINDOWS
+	if (_mapped) {
+		munmap (const_cast<uint8_t*>(_data), _size);
+	}
+#endif
+}
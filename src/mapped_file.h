@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+/** @file  src/mapped_file.h
+ *  @brief MappedFile class.
+ */
+
+
+#ifndef LIBDCP_MAPPED_FILE_H
+#define LIBDCP_MAPPED_FILE_H
+
+
+#include <boost/filesystem.hpp>
+#include <stdint.h>
+#include <vector>
+
+
+namespace dcp {
+
+
+/** @class MappedFile
+ *  @brief The contents of a file, mapped read-only into memory.
+ *
+ *  Where the OS does not support mapping (Windows, at present) the file is read into memory instead.
+ */
+class MappedFile
+{
+public:
+	explicit MappedFile (boost::filesystem::path file);
+	~MappedFile ();
+
+	MappedFile (MappedFile const&) = delete;
+	MappedFile& operator= (MappedFile const&) = delete;
+
+	uint8_t const * data () const {
+		return _data;
+	}
+
+	uint64_t size () const {
+		return _size;
+	}
+
+private:
+	uint8_t const * _data = nullptr;
+	uint64_t _size = 0;
+	/** true if _data is mapped, false if it points into _copy */
+	bool _mapped = false;
+	std::vector<uint8_t> _copy;
+};
+
+
+}
+
+
+#endif
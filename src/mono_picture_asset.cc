@@ -190,10 +190,16 @@ MonoPictureAsset::start_write (boost::filesystem::path file, bool overwrite)
 }
 
 shared_ptr<MonoPictureAssetReader>
-MonoPictureAsset::start_read () const
+MonoPictureAsset::start_read (bool map) const
 {
 	/* Can't use make_shared here as the MonoPictureAssetReader constructor is private */
-	return shared_ptr<MonoPictureAssetReader>(new MonoPictureAssetReader(this, key(), standard()));
+	auto reader = shared_ptr<MonoPictureAssetReader>(new MonoPictureAssetReader(this, key(), standard(), intrinsic_duration()));
+	if (map) {
+		if (auto essence = map_essence()) {
+			reader->map (essence);
+		}
+	}
+	return reader;
 
 }
 
@@ -74,7 +74,13 @@ public:
 	 *  previously failed.  If in doubt, use false here.
 	 */
 	std::shared_ptr<PictureAssetWriter> start_write (boost::filesystem::path file, bool overwrite) override;
-	std::shared_ptr<MonoPictureAssetReader> start_read () const;
+	/** @param map true to make the reader return frames which point straight into a memory-mapped
+	 *  copy of the MXF, so that their data is never copied.  This is only possible for unencrypted
+	 *  assets which have an up-to-date frame index (see PictureAssetWriter::set_write_frame_index());
+	 *  otherwise, or if the OS cannot map the file, frames are read in the usual way.  AssetReader::mapped()
+	 *  says which happened.  The data of mapped frames must not be modified.
+	 */
+	std::shared_ptr<MonoPictureAssetReader> start_read (bool map = false) const;
 
 	bool equals (
 		std::shared_ptr<const Asset> other,
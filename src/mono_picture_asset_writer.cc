@@ -104,7 +104,10 @@ MonoPictureAssetWriter::write (uint8_t const * data, int size)
 	}
 
 	++_frames_written;
-	return FrameInfo (before_offset, _state->mxf_writer.Tell() - before_offset, hash);
+
+	FrameInfo info (before_offset, _state->mxf_writer.Tell() - before_offset, hash);
+	add_to_frame_index (info, size);
+	return info;
 }
 
 
@@ -119,6 +122,8 @@ MonoPictureAssetWriter::fake_write (int size)
 		boost::throw_exception (MXFFileError("error in writing video MXF", _file.string(), r));
 	}
 
+	_frame_index_complete = false;
+
 	++_frames_written;
 }
 
@@ -42,6 +42,7 @@
 #include "crypto_context.h"
 #include "exceptions.h"
 #include "j2k_transcode.h"
+#include "mapped_essence.h"
 #include "mono_picture_frame.h"
 #include "rgb_xyz.h"
 #include "util.h"
@@ -56,6 +57,9 @@ using boost::optional;
 using namespace dcp;
 
 
+int constexpr MonoPictureFrame::initial_buffer_capacity;
+
+
 MonoPictureFrame::MonoPictureFrame (boost::filesystem::path path)
 {
 	auto const size = boost::filesystem::file_size (path);
@@ -81,13 +85,17 @@ MonoPictureFrame::MonoPictureFrame (boost::filesystem::path path)
  *  @param n Frame within the asset, not taking EntryPoint into account.
  *  @param c Context for decryption, or 0.
  *  @param check_hmac true to check the HMAC and give an error if it is not as expected.
+ *  @param pool Pool to take our buffer from.
  */
-MonoPictureFrame::MonoPictureFrame (ASDCP::JP2K::MXFReader* reader, int n, shared_ptr<DecryptionContext> c, bool check_hmac)
+MonoPictureFrame::MonoPictureFrame (
+	ASDCP::JP2K::MXFReader* reader,
+	int n,
+	shared_ptr<DecryptionContext> c,
+	bool check_hmac,
+	shared_ptr<FrameBufferPool<Buffer>> pool
+	)
 {
-	/* XXX: unfortunate guesswork on this buffer size */
-	_buffer = make_shared<ASDCP::JP2K::FrameBuffer>(4 * Kumu::Megabyte);
-
-	auto const r = reader->ReadFrame (n, *_buffer, c->context(), check_hmac ? c->hmac() : nullptr);
+	auto const r = pool->read (reader, n, *c, check_hmac, _buffer);
 
 	if (ASDCP_FAILURE(r)) {
 		boost::throw_exception (ReadError(String::compose ("could not read video frame %1 (%2)", n, static_cast<int>(r))));
@@ -95,6 +103,20 @@ MonoPictureFrame::MonoPictureFrame (ASDCP::JP2K::MXFReader* reader, int n, share
 }
 
 
+/** Make a picture frame whose data is part of some mapped essence, without copying it.
+ *  @param essence Mapped essence of a 2D asset.
+ *  @param n Frame within the asset, not taking EntryPoint into account.
+ */
+MonoPictureFrame::MonoPictureFrame (shared_ptr<const MappedEssence> essence, int n)
+{
+	auto const span = essence->get (n);
+	/* The buffer does not own the data, and it keeps the mapping alive for as long as it is around */
+	_buffer.reset (new ASDCP::JP2K::FrameBuffer(), [essence](ASDCP::JP2K::FrameBuffer* buffer) { delete buffer; });
+	_buffer->SetData (const_cast<uint8_t*>(span.data), span.size);
+	_buffer->Size (span.size);
+}
+
+
 MonoPictureFrame::MonoPictureFrame (uint8_t const * data, int size)
 {
 	_buffer = make_shared<ASDCP::JP2K::FrameBuffer>(size);
@@ -129,3 +151,12 @@ MonoPictureFrame::xyz_image (int reduce) const
 {
 	return decompress_j2k (const_cast<uint8_t*>(_buffer->RoData()), _buffer->Size(), reduce);
 }
+
+
+#ifndef LIBDCP_OPENJPEG1
+shared_ptr<OpenJPEGImage>
+MonoPictureFrame::xyz_image (J2KDecoder& decoder) const
+{
+	return decoder.decode (_buffer->RoData(), _buffer->Size());
+}
+#endif
@@ -42,6 +42,7 @@
 
 
 #include "asset_reader.h"
+#include "frame_buffer_pool.h"
 #include "types.h"
 #include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
@@ -62,6 +63,8 @@ namespace ASDCP {
 namespace dcp {
 
 
+class J2KDecoder;
+class MappedEssence;
 class OpenJPEGImage;
 
 
@@ -71,6 +74,11 @@ class OpenJPEGImage;
 class MonoPictureFrame : public Data
 {
 public:
+	typedef ASDCP::JP2K::FrameBuffer Buffer;
+
+	/** XXX: unfortunate guesswork on this buffer size */
+	static int constexpr initial_buffer_capacity = 4 * Kumu::Megabyte;
+
 	/** Make a picture frame from a JPEG2000 file.
 	 *  @param path Path to JPEG2000 file.
 	 */
@@ -86,6 +94,11 @@ public:
 	 */
 	std::shared_ptr<OpenJPEGImage> xyz_image (int reduce = 0) const;
 
+#ifndef LIBDCP_OPENJPEG1
+	/** @param decoder Decoder to use; this can be kept between frames to avoid setting it up for each one */
+	std::shared_ptr<OpenJPEGImage> xyz_image (J2KDecoder& decoder) const;
+#endif
+
 	/** @return Pointer to JPEG2000 data */
 	uint8_t const * data () const override;
 
@@ -101,7 +114,15 @@ private:
 	*/
 	friend class AssetReader<ASDCP::JP2K::MXFReader, MonoPictureFrame>;
 
-	MonoPictureFrame (ASDCP::JP2K::MXFReader* reader, int n, std::shared_ptr<DecryptionContext>, bool check_hmac);
+	MonoPictureFrame (
+		ASDCP::JP2K::MXFReader* reader,
+		int n,
+		std::shared_ptr<DecryptionContext>,
+		bool check_hmac,
+		std::shared_ptr<FrameBufferPool<Buffer>> pool
+		);
+
+	MonoPictureFrame (std::shared_ptr<const MappedEssence> essence, int n);
 
 	std::shared_ptr<ASDCP::JP2K::FrameBuffer> _buffer;
 };
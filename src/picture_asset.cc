@@ -40,6 +40,8 @@
 #include "picture_asset.h"
 #include "util.h"
 #include "exceptions.h"
+#include "frame_index.h"
+#include "mapped_essence.h"
 #include "openjpeg_image.h"
 #include "picture_asset_writer.h"
 #include "dcp_assert.h"
@@ -229,3 +231,25 @@ PictureAsset::pkl_type (Standard standard) const
 {
 	return static_pkl_type (standard);
 }
+
+
+shared_ptr<const FrameIndex>
+PictureAsset::frame_index () const
+{
+	if (!file()) {
+		return {};
+	}
+
+	return FrameIndex::load (*file());
+}
+
+
+shared_ptr<const MappedEssence>
+PictureAsset::map_essence () const
+{
+	if (!file() || encrypted()) {
+		return {};
+	}
+
+	return MappedEssence::open (*file());
+}
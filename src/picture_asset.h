@@ -56,6 +56,8 @@ namespace ASDCP {
 namespace dcp {
 
 
+class FrameIndex;
+class MappedEssence;
 class MonoPictureFrame;
 class StereoPictureFrame;
 class PictureAssetWriter;
@@ -110,6 +112,11 @@ public:
 		return _intrinsic_duration;
 	}
 
+	/** @return Index of this asset's frames from its sidecar file, or nullptr if there is no
+	 *  sidecar or it is out of date.  The sidecar is read each time this is called.
+	 */
+	std::shared_ptr<const FrameIndex> frame_index () const;
+
 	static std::string static_pkl_type (Standard standard);
 
 protected:
@@ -129,6 +136,9 @@ protected:
 
 	void read_picture_descriptor (ASDCP::JP2K::PictureDescriptor const &);
 
+	/** @return This asset's essence mapped into memory, or nullptr if that is not possible */
+	std::shared_ptr<const MappedEssence> map_essence () const;
+
 	Fraction _edit_rate;
 	/** The total length of this content in video frames.  The amount of
 	 *  content presented may be less than this.
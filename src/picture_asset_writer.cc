@@ -65,3 +65,29 @@ PictureAssetWriter::write (Data const& data)
 {
 	return write (data.data(), data.size());
 }
+
+
+void
+PictureAssetWriter::add_to_frame_index (FrameInfo const& info, int essence_size)
+{
+	if (_write_frame_index) {
+		_frame_index.add ({ info.offset, static_cast<uint32_t>(info.size), static_cast<uint32_t>(essence_size) });
+	}
+}
+
+
+bool
+PictureAssetWriter::finalize ()
+{
+	if (_started) {
+		if (_write_frame_index && _frame_index_complete) {
+			_frame_index.write (_file);
+		} else {
+			/* Make sure that nobody uses an index from an earlier version of this asset */
+			boost::system::error_code ec;
+			boost::filesystem::remove (FrameIndex::sidecar(_file), ec);
+		}
+	}
+
+	return AssetWriter::finalize ();
+}
@@ -42,6 +42,7 @@
 
 
 #include "asset_writer.h"
+#include "frame_index.h"
 #include "metadata.h"
 #include "types.h"
 #include <boost/utility.hpp>
@@ -87,14 +88,31 @@ public:
 
 	FrameInfo write (Data const& data);
 
+	bool finalize () override;
+
+	/** @param write true to write a FrameIndex of the asset to its sidecar file (see FrameIndex::sidecar())
+	 *  in finalize().  No index will be written if fake_write() is used, as the sizes of the faked frames'
+	 *  codestreams are not known.  If no index is written, finalize() removes any sidecar left from an
+	 *  earlier version of the asset.
+	 */
+	void set_write_frame_index (bool write) {
+		_write_frame_index = write;
+	}
+
 protected:
 	template <class P, class Q>
 	friend void start (PictureAssetWriter *, std::shared_ptr<P>, Q *, uint8_t const *, int);
 
 	PictureAssetWriter (PictureAsset *, boost::filesystem::path, bool);
 
+	void add_to_frame_index (FrameInfo const& info, int essence_size);
+
 	PictureAsset* _picture_asset = nullptr;
 	bool _overwrite = false;
+	bool _write_frame_index = false;
+	/** false if fake_write() has been used, so that _frame_index is missing some information */
+	bool _frame_index_complete = true;
+	FrameIndex _frame_index;
 };
 
 
@@ -81,7 +81,7 @@ PKL::PKL (boost::filesystem::path file)
 	_creator = pkl.string_child ("Creator");
 
 	for (auto i: pkl.node_child("AssetList")->node_children("Asset")) {
-		_asset_list.push_back (make_shared<Asset>(i));
+		add_asset (make_shared<Asset>(i));
 	}
 }
 
@@ -89,7 +89,16 @@ PKL::PKL (boost::filesystem::path file)
 void
 PKL::add_asset (std::string id, boost::optional<std::string> annotation_text, std::string hash, int64_t size, std::string type)
 {
-	_asset_list.push_back (make_shared<Asset>(id, annotation_text, hash, size, type));
+	add_asset (make_shared<Asset>(id, annotation_text, hash, size, type));
+}
+
+
+void
+PKL::add_asset (shared_ptr<Asset> asset)
+{
+	_asset_list.push_back (asset);
+	/* This does nothing if we already have an asset with this ID, so lookups find the first one as they always have */
+	_asset_by_id.emplace (asset->id(), asset);
 }
 
 
@@ -138,24 +147,22 @@ PKL::write (boost::filesystem::path file, shared_ptr<const CertificateChain> sig
 optional<string>
 PKL::hash (string id) const
 {
-	for (auto i: _asset_list) {
-		if (i->id() == id) {
-			return i->hash();
-		}
+	auto i = _asset_by_id.find (id);
+	if (i == _asset_by_id.end()) {
+		return {};
 	}
 
-	return {};
+	return i->second->hash();
 }
 
 
 optional<string>
 PKL::type (string id) const
 {
-	for (auto i: _asset_list) {
-		if (i->id() == id) {
-			return i->type();
-		}
+	auto i = _asset_by_id.find (id);
+	if (i == _asset_by_id.end()) {
+		return {};
 	}
 
-	return {};
+	return i->second->type();
 }
@@ -47,6 +47,7 @@
 #include "certificate_chain.h"
 #include <libcxml/cxml.h>
 #include <boost/filesystem.hpp>
+#include <unordered_map>
 
 
 namespace dcp {
@@ -84,6 +85,10 @@ public:
 		return _file;
 	}
 
+	void set_file (boost::filesystem::path file) const {
+		_file = file;
+	}
+
 	class Asset : public Object
 	{
 	public:
@@ -131,6 +136,7 @@ public:
 	}
 
 private:
+	void add_asset (std::shared_ptr<Asset> asset);
 
 	Standard _standard = dcp::Standard::SMPTE;
 	boost::optional<std::string> _annotation_text;
@@ -138,6 +144,8 @@ private:
 	std::string _issuer;
 	std::string _creator;
 	std::vector<std::shared_ptr<Asset>> _asset_list;
+	/** The first asset in _asset_list with each ID */
+	std::unordered_map<std::string, std::shared_ptr<Asset>> _asset_by_id;
 	/** The most recent disk file used to read or write this PKL */
 	mutable boost::optional<boost::filesystem::path> _file;
 };
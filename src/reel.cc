@@ -37,6 +37,7 @@
  */
 
 
+#include "asset_index.h"
 #include "reel.h"
 #include "util.h"
 #include "picture_asset.h"
@@ -398,6 +399,13 @@ Reel::assets () const
 
 void
 Reel::resolve_refs (vector<shared_ptr<Asset>> assets)
+{
+	resolve_refs (AssetIndex(assets));
+}
+
+
+void
+Reel::resolve_refs (AssetIndex const& assets)
 {
 	if (_main_picture) {
 		_main_picture->asset_ref().resolve(assets);
@@ -410,8 +418,10 @@ Reel::resolve_refs (vector<shared_ptr<Asset>> assets)
 	if (_main_subtitle) {
 		_main_subtitle->asset_ref().resolve(assets);
 
-		/* Interop subtitle handling is all special cases */
-		if (_main_subtitle->asset_ref().resolved()) {
+		/* Interop subtitle handling is all special cases.  An asset which has not been made
+		   yet will have its fonts resolved when it is made.
+		*/
+		if (_main_subtitle->asset_ref().loaded()) {
 			auto iop = dynamic_pointer_cast<InteropSubtitleAsset> (_main_subtitle->asset_ref().asset());
 			if (iop) {
 				iop->resolve_fonts (assets);
@@ -423,7 +433,7 @@ Reel::resolve_refs (vector<shared_ptr<Asset>> assets)
 		i->asset_ref().resolve(assets);
 
 		/* Interop subtitle handling is all special cases */
-		if (i->asset_ref().resolved()) {
+		if (i->asset_ref().loaded()) {
 			auto iop = dynamic_pointer_cast<InteropSubtitleAsset> (i->asset_ref().asset());
 			if (iop) {
 				iop->resolve_fonts (assets);
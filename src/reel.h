@@ -65,6 +65,7 @@ struct dcp_add_kdm_test;
 namespace dcp {
 
 
+class AssetIndex;
 class DecryptedKDM;
 class ReelAsset;
 class ReelPictureAsset;
@@ -138,6 +139,7 @@ public:
 	void add (DecryptedKDM const &);
 
 	void resolve_refs (std::vector<std::shared_ptr<Asset>>);
+	void resolve_refs (AssetIndex const& assets);
 
 private:
 	friend struct ::dcp_add_kdm_test;
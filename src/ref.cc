@@ -37,6 +37,7 @@
  */
 
 
+#include "asset_index.h"
 #include "ref.h"
 
 
@@ -55,5 +56,19 @@ Ref::resolve (vector<shared_ptr<Asset>> assets)
 
 	if (i != assets.end ()) {
 		_asset = *i;
+		_lazy.reset ();
+	}
+}
+
+
+void
+Ref::resolve (AssetIndex const& assets)
+{
+	if (auto asset = assets.find(_id)) {
+		_asset = asset;
+		_lazy.reset ();
+	} else if (auto lazy = assets.find_lazy(_id)) {
+		_asset.reset ();
+		_lazy = lazy;
 	}
 }
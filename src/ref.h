@@ -43,6 +43,7 @@
 
 #include "exceptions.h"
 #include "asset.h"
+#include "lazy_asset.h"
 #include "util.h"
 #include <memory>
 #include <string>
@@ -51,6 +52,9 @@
 namespace dcp {
 
 
+class AssetIndex;
+
+
 /** @class Ref
  *  @brief A reference to an asset which is identified by a universally-unique identifier (UUID)
  *
@@ -61,6 +65,9 @@ namespace dcp {
  *  If the Ref does not have a shared_ptr it may be given one by
  *  calling resolve() with a vector of assets.  The shared_ptr will be
  *  set up using any object on the vector which has a matching ID.
+ *
+ *  A Ref may also be resolved to a LazyAsset, in which case the
+ *  asset is made the first time that asset() or operator-> is used.
  */
 class Ref
 {
@@ -87,15 +94,25 @@ public:
 	 */
 	void resolve (std::vector<std::shared_ptr<Asset>> assets);
 
+	/** Copy a shared_ptr to any asset in an index which matches the ID of this one */
+	void resolve (AssetIndex const& assets);
+
 	/** @return the ID of the thing that we are pointing to */
 	std::string id () const {
 		return _id;
 	}
 
 	/** @return a shared_ptr to the thing; an UnresolvedRefError is thrown
-	 *  if the shared_ptr is not known
+	 *  if the shared_ptr is not known.  If this Ref was resolved to a LazyAsset
+	 *  which has not been made yet, it is made now, and any error from doing that
+	 *  is thrown; this includes an UnresolvedRefError if the asset turns out to
+	 *  have a different ID.
 	 */
 	std::shared_ptr<Asset> asset () const {
+		if (_lazy) {
+			return _lazy->get ();
+		}
+
 		if (!_asset) {
 			throw UnresolvedRefError (_id);
 		}
@@ -107,21 +124,31 @@ public:
 	 *  if the shared_ptr is not known
 	 */
 	Asset * operator->() const {
-		if (!_asset) {
-			throw UnresolvedRefError (_id);
-		}
-
-		return _asset.get ();
+		/* The LazyAsset keeps the asset alive, so we can return a plain pointer to it */
+		return asset().get();
 	}
 
-	/** @return true if a shared_ptr is known for this Ref */
+	/** @return true if a shared_ptr is known for this Ref, or it will be made when it is asked for */
 	bool resolved () const {
-		return static_cast<bool>(_asset);
+		return _asset || _lazy;
+	}
+
+	/** @return true if a shared_ptr is known for this Ref and, if it was resolved
+	 *  to a LazyAsset, the asset has been made.
+	 */
+	bool loaded () const {
+		return _asset || (_lazy && _lazy->loaded());
+	}
+
+	/** @return the LazyAsset that this Ref was resolved to, or nullptr if it was not resolved to one */
+	std::shared_ptr<LazyAsset> lazy_asset () const {
+		return _lazy;
 	}
 
 private:
 	std::string _id;             ///< ID; will always be known
 	std::shared_ptr<Asset> _asset; ///< shared_ptr to the thing, may be null.
+	std::shared_ptr<LazyAsset> _lazy; ///< thing to make the asset when it is needed, may be null.
 };
 
 
@@ -40,10 +40,22 @@
 #include "colour_conversion.h"
 #include "compose.hpp"
 #include "dcp_assert.h"
+#include "fixed_point_colour_conversion.h"
 #include "openjpeg_image.h"
 #include "rgb_xyz.h"
 #include "transfer_function.h"
 #include <cmath>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <thread>
+/* The SIMD kernels must give exactly the same results as the scalar one, so we only use them where
+   the scalar one does its double arithmetic with SSE2 rather than with the x87's extended precision.
+*/
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2_MATH__)))
+#define LIBDCP_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 
 using std::cout;
@@ -51,6 +63,7 @@ using std::make_shared;
 using std::max;
 using std::min;
 using std::shared_ptr;
+using std::vector;
 using boost::optional;
 using namespace dcp;
 
@@ -58,12 +71,93 @@ using namespace dcp;
 static auto constexpr DCI_COEFFICIENT = 48.0 / 52.37;
 
 
-void
-dcp::xyz_to_rgba (
-	std::shared_ptr<const OpenJPEGImage> xyz_image,
-	ColourConversion const & conversion,
+/** Split the lines [0, height) of an image into at most @p threads bands and call
+ *  @p job (band index, first line, last line + 1) for each band.  The first band is
+ *  done on the calling thread and the others each on a thread of their own.  If any
+ *  job throws, the exception from the lowest-numbered band is re-thrown here once all
+ *  the bands have finished.
+ */
+static void
+for_each_band (int height, int threads, std::function<void (int, int, int)> job)
+{
+	int const bands = max (1, min (threads, height));
+
+	vector<std::exception_ptr> errors (bands);
+	auto run = [&](int band) {
+		try {
+			job (band, height * band / bands, height * (band + 1) / bands);
+		} catch (...) {
+			errors[band] = std::current_exception ();
+		}
+	};
+
+	vector<std::thread> workers;
+	for (int i = 1; i < bands; ++i) {
+		workers.push_back (std::thread(run, i));
+	}
+	run (0);
+	for (auto& i: workers) {
+		i.join ();
+	}
+
+	for (auto i: errors) {
+		if (i) {
+			std::rethrow_exception (i);
+		}
+	}
+}
+
+
+static inline int
+clamp_12_bit (int v)
+{
+	return max (min (v, 4095), 0);
+}
+
+
+/** Multiply a fixed-point vector by a fixed-point matrix row from FixedPointColourConversion,
+ *  giving an (unclamped) index into the corresponding output LUT.
+ */
+static inline int64_t
+fixed_point_product (int64_t const * row, int64_t a, int64_t b, int64_t c)
+{
+	int constexpr shift = FixedPointColourConversion::shift;
+	return (a * row[0] + b * row[1] + c * row[2] + (int64_t(1) << (shift - 1))) >> shift;
+}
+
+
+/** As fixed_point_product(), but clamp the index to 0-65535.
+ *  @param clamped Set to 1 if clamping was necessary.
+ */
+static inline int
+fixed_point_row (int64_t const * row, int64_t a, int64_t b, int64_t c, int& clamped)
+{
+	int64_t const v = fixed_point_product (row, a, b, c);
+	/* This is branch-free as it's quite common for the clamps to be unpredictable */
+	clamped |= (v < 0) | (v > 65535);
+	return static_cast<int>(min(max(v, int64_t(0)), int64_t(65535)));
+}
+
+
+/** As fixed_point_product(), but clamp the index to 0-65535 */
+static inline int
+fixed_point_row (int64_t const * row, int64_t a, int64_t b, int64_t c)
+{
+	return static_cast<int>(min(max(fixed_point_product(row, a, b, c), int64_t(0)), int64_t(65535)));
+}
+
+
+/** Convert lines [start, end) of an XYZ image to RGBA; see xyz_to_rgba() */
+static void
+xyz_to_rgba_lines (
+	OpenJPEGImage const & xyz_image,
+	double const * lut_in,
+	double const * lut_out,
+	double const * fast_matrix,
 	uint8_t* argb,
-	int stride
+	int stride,
+	int start,
+	int end
 	)
 {
 	int const max_colour = pow (2, 16) - 1;
@@ -76,24 +170,15 @@ dcp::xyz_to_rgba (
 		double r, g, b;
 	} d;
 
-	int* xyz_x = xyz_image->data (0);
-	int* xyz_y = xyz_image->data (1);
-	int* xyz_z = xyz_image->data (2);
+	int const width = xyz_image.size().width;
 
-	double const * lut_in = conversion.out()->lut (12, false);
-	double const * lut_out = conversion.in()->lut (16, true);
-	boost::numeric::ublas::matrix<double> const matrix = conversion.xyz_to_rgb ();
+	int* xyz_x = xyz_image.data(0) + start * width;
+	int* xyz_y = xyz_image.data(1) + start * width;
+	int* xyz_z = xyz_image.data(2) + start * width;
 
-	double fast_matrix[9] = {
-		matrix (0, 0), matrix (0, 1), matrix (0, 2),
-		matrix (1, 0), matrix (1, 1), matrix (1, 2),
-		matrix (2, 0), matrix (2, 1), matrix (2, 2)
-	};
-
-	int const height = xyz_image->size().height;
-	int const width = xyz_image->size().width;
+	argb += start * stride;
 
-	for (int y = 0; y < height; ++y) {
+	for (int y = start; y < end; ++y) {
 		uint8_t* argb_line = argb;
 		for (int x = 0; x < width; ++x) {
 
@@ -135,13 +220,66 @@ dcp::xyz_to_rgba (
 }
 
 
+static void
+xyz_to_rgb_fast_matrix (ColourConversion const & conversion, double* fast_matrix)
+{
+	auto const matrix = conversion.xyz_to_rgb ();
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			fast_matrix[i * 3 + j] = matrix (i, j);
+		}
+	}
+}
+
+
 void
-dcp::xyz_to_rgb (
-	shared_ptr<const OpenJPEGImage> xyz_image,
+dcp::xyz_to_rgba (
+	std::shared_ptr<const OpenJPEGImage> xyz_image,
 	ColourConversion const & conversion,
+	uint8_t* argb,
+	int stride
+	)
+{
+	xyz_to_rgba (xyz_image, conversion, argb, stride, 1);
+}
+
+
+void
+dcp::xyz_to_rgba (
+	std::shared_ptr<const OpenJPEGImage> xyz_image,
+	ColourConversion const & conversion,
+	uint8_t* argb,
+	int stride,
+	int threads
+	)
+{
+	double const * lut_in = conversion.out()->lut (12, false);
+	double const * lut_out = conversion.in()->lut (16, true);
+
+	double fast_matrix[9];
+	xyz_to_rgb_fast_matrix (conversion, fast_matrix);
+
+	for_each_band (xyz_image->size().height, threads, [&](int, int start, int end) {
+		xyz_to_rgba_lines (*xyz_image, lut_in, lut_out, fast_matrix, argb, stride, start, end);
+	});
+}
+
+
+/** Convert lines [start, end) of an XYZ image to RGB; see xyz_to_rgb().
+ *  @param out_of_range If non-null, filled with any out-of-range XYZ values that are found
+ *  (and clamped), in the order that they were found.
+ */
+static void
+xyz_to_rgb_lines (
+	OpenJPEGImage const & xyz_image,
+	double const * lut_in,
+	double const * lut_out,
+	double const * fast_matrix,
 	uint8_t* rgb,
 	int stride,
-	optional<NoteHandler> note
+	int start,
+	int end,
+	vector<int>* out_of_range
 	)
 {
 	struct {
@@ -152,25 +290,14 @@ dcp::xyz_to_rgb (
 		double r, g, b;
 	} d;
 
-	/* These should be 12-bit values from 0-4095 */
-	int* xyz_x = xyz_image->data (0);
-	int* xyz_y = xyz_image->data (1);
-	int* xyz_z = xyz_image->data (2);
-
-	double const * lut_in = conversion.out()->lut (12, false);
-	double const * lut_out = conversion.in()->lut (16, true);
-	auto const matrix = conversion.xyz_to_rgb ();
-
-	double fast_matrix[9] = {
-		matrix (0, 0), matrix (0, 1), matrix (0, 2),
-		matrix (1, 0), matrix (1, 1), matrix (1, 2),
-		matrix (2, 0), matrix (2, 1), matrix (2, 2)
-	};
+	int const width = xyz_image.size().width;
 
-	int const height = xyz_image->size().height;
-	int const width = xyz_image->size().width;
+	/* These should be 12-bit values from 0-4095 */
+	int* xyz_x = xyz_image.data(0) + start * width;
+	int* xyz_y = xyz_image.data(1) + start * width;
+	int* xyz_z = xyz_image.data(2) + start * width;
 
-	for (int y = 0; y < height; ++y) {
+	for (int y = start; y < end; ++y) {
 		auto rgb_line = reinterpret_cast<uint16_t*> (rgb + y * stride);
 		for (int x = 0; x < width; ++x) {
 
@@ -179,22 +306,22 @@ dcp::xyz_to_rgb (
 			int cz = *xyz_z++;
 
 			if (cx < 0 || cx > 4095) {
-				if (note) {
-					note.get()(NoteType::NOTE, String::compose("XYZ value %1 out of range", cx));
+				if (out_of_range) {
+					out_of_range->push_back (cx);
 				}
 				cx = max (min (cx, 4095), 0);
 			}
 
 			if (cy < 0 || cy > 4095) {
-				if (note) {
-					note.get()(NoteType::NOTE, String::compose("XYZ value %1 out of range", cy));
+				if (out_of_range) {
+					out_of_range->push_back (cy);
 				}
 				cy = max (min (cy, 4095), 0);
 			}
 
 			if (cz < 0 || cz > 4095) {
-				if (note) {
-					note.get()(NoteType::NOTE, String::compose("XYZ value %1 out of range", cz));
+				if (out_of_range) {
+					out_of_range->push_back (cz);
 				}
 				cz = max (min (cz, 4095), 0);
 			}
@@ -230,6 +357,122 @@ dcp::xyz_to_rgb (
 	}
 }
 
+
+void
+dcp::xyz_to_rgb (
+	shared_ptr<const OpenJPEGImage> xyz_image,
+	ColourConversion const & conversion,
+	uint8_t* rgb,
+	int stride,
+	optional<NoteHandler> note
+	)
+{
+	xyz_to_rgb (xyz_image, conversion, rgb, stride, 1, note);
+}
+
+
+void
+dcp::xyz_to_rgb (
+	shared_ptr<const OpenJPEGImage> xyz_image,
+	ColourConversion const & conversion,
+	uint8_t* rgb,
+	int stride,
+	int threads,
+	optional<NoteHandler> note
+	)
+{
+	double const * lut_in = conversion.out()->lut (12, false);
+	double const * lut_out = conversion.in()->lut (16, true);
+
+	double fast_matrix[9];
+	xyz_to_rgb_fast_matrix (conversion, fast_matrix);
+
+	/* Out-of-range values found by each band, so that we can report them in the
+	   same order as if we had done the whole image on one thread.
+	*/
+	vector<vector<int>> out_of_range (max(1, threads));
+
+	for_each_band (xyz_image->size().height, threads, [&](int band, int start, int end) {
+		xyz_to_rgb_lines (*xyz_image, lut_in, lut_out, fast_matrix, rgb, stride, start, end, note ? &out_of_range[band] : nullptr);
+	});
+
+	if (note) {
+		for (auto const& i: out_of_range) {
+			for (auto j: i) {
+				note.get()(NoteType::NOTE, String::compose("XYZ value %1 out of range", j));
+			}
+		}
+	}
+}
+
+
+void
+dcp::xyz_to_rgba (
+	std::shared_ptr<const OpenJPEGImage> xyz_image,
+	FixedPointColourConversion const & conversion,
+	uint8_t* argb,
+	int stride,
+	int threads
+	)
+{
+	auto const lut_in = conversion.xyz_to_rgb_in ();
+	auto const matrix = conversion.xyz_to_rgb_matrix ();
+	auto const lut_out = conversion.xyz_to_rgba_out ();
+	int const width = xyz_image->size().width;
+
+	for_each_band (xyz_image->size().height, threads, [&](int, int start, int end) {
+		int* xyz_x = xyz_image->data(0) + start * width;
+		int* xyz_y = xyz_image->data(1) + start * width;
+		int* xyz_z = xyz_image->data(2) + start * width;
+		for (int y = start; y < end; ++y) {
+			uint8_t* argb_line = argb + y * stride;
+			for (int x = 0; x < width; ++x) {
+				int64_t const sx = lut_in[clamp_12_bit(*xyz_x++)];
+				int64_t const sy = lut_in[clamp_12_bit(*xyz_y++)];
+				int64_t const sz = lut_in[clamp_12_bit(*xyz_z++)];
+				*argb_line++ = lut_out[fixed_point_row(matrix + 6, sx, sy, sz)];
+				*argb_line++ = lut_out[fixed_point_row(matrix + 3, sx, sy, sz)];
+				*argb_line++ = lut_out[fixed_point_row(matrix + 0, sx, sy, sz)];
+				*argb_line++ = 0xff;
+			}
+		}
+	});
+}
+
+
+void
+dcp::xyz_to_rgb (
+	std::shared_ptr<const OpenJPEGImage> xyz_image,
+	FixedPointColourConversion const & conversion,
+	uint8_t* rgb,
+	int stride,
+	int threads
+	)
+{
+	auto const lut_in = conversion.xyz_to_rgb_in ();
+	auto const matrix = conversion.xyz_to_rgb_matrix ();
+	auto const lut_out = conversion.xyz_to_rgb_out ();
+	int const width = xyz_image->size().width;
+
+	for_each_band (xyz_image->size().height, threads, [&](int, int start, int end) {
+		int* xyz_x = xyz_image->data(0) + start * width;
+		int* xyz_y = xyz_image->data(1) + start * width;
+		int* xyz_z = xyz_image->data(2) + start * width;
+		for (int y = start; y < end; ++y) {
+			auto rgb_line = reinterpret_cast<uint16_t*> (rgb + y * stride);
+			for (int x = 0; x < width; ++x) {
+				int64_t const sx = lut_in[clamp_12_bit(*xyz_x++)];
+				int64_t const sy = lut_in[clamp_12_bit(*xyz_y++)];
+				int64_t const sz = lut_in[clamp_12_bit(*xyz_z++)];
+				*rgb_line++ = lut_out[fixed_point_row(matrix + 0, sx, sy, sz)];
+				*rgb_line++ = lut_out[fixed_point_row(matrix + 3, sx, sy, sz)];
+				*rgb_line++ = lut_out[fixed_point_row(matrix + 6, sx, sy, sz)];
+			}
+		}
+	});
+}
+
+
 void
 dcp::combined_rgb_to_xyz (ColourConversion const & conversion, double* matrix)
 {
@@ -257,6 +500,226 @@ dcp::combined_rgb_to_xyz (ColourConversion const & conversion, double* matrix)
 }
 
 
+/** Convert one line of RGB to XYZ one pixel at a time.
+ *  @param p RGB data for the line, as for rgb_to_xyz().
+ *  @param width Number of pixels to convert.
+ *  @param lut_in 12-bit input gamma LUT.
+ *  @param lut_out 16-bit output (inverse) gamma LUT.
+ *  @param matrix Combined matrix from combined_rgb_to_xyz().
+ *  @return Number of pixels that were clamped.
+ */
+static int
+rgb_to_xyz_line_scalar (
+	uint16_t const * p,
+	int width,
+	double const * lut_in,
+	double const * lut_out,
+	double const * matrix,
+	int* xyz_x,
+	int* xyz_y,
+	int* xyz_z
+	)
+{
+	struct {
+		double r, g, b;
+	} s;
+
+	struct {
+		double x, y, z;
+	} d;
+
+	int clamped = 0;
+
+	for (int x = 0; x < width; ++x) {
+
+		/* In gamma LUT (converting 16-bit to 12-bit) */
+		s.r = lut_in[*p++ >> 4];
+		s.g = lut_in[*p++ >> 4];
+		s.b = lut_in[*p++ >> 4];
+
+		/* RGB to XYZ, Bradford transform and DCI companding */
+		d.x = s.r * matrix[0] + s.g * matrix[1] + s.b * matrix[2];
+		d.y = s.r * matrix[3] + s.g * matrix[4] + s.b * matrix[5];
+		d.z = s.r * matrix[6] + s.g * matrix[7] + s.b * matrix[8];
+
+		/* Clamp */
+
+		if (d.x < 0 || d.y < 0 || d.z < 0 || d.x > 65535 || d.y > 65535 || d.z > 65535) {
+			++clamped;
+		}
+
+		d.x = max (0.0, d.x);
+		d.y = max (0.0, d.y);
+		d.z = max (0.0, d.z);
+		d.x = min (65535.0, d.x);
+		d.y = min (65535.0, d.y);
+		d.z = min (65535.0, d.z);
+
+		/* Out gamma LUT */
+		*xyz_x++ = lrint (lut_out[lrint(d.x)] * 4095);
+		*xyz_y++ = lrint (lut_out[lrint(d.y)] * 4095);
+		*xyz_z++ = lrint (lut_out[lrint(d.z)] * 4095);
+	}
+
+	return clamped;
+}
+
+
+#ifdef LIBDCP_X86_KERNELS
+
+
+/* The vector kernels below do exactly the same double-precision arithmetic, in the same order,
+ * as rgb_to_xyz_line_scalar, and round using the current (round-to-nearest) mode just as lrint
+ * does, so their output is bit-identical to the scalar version.  They must not be compiled with
+ * FMA enabled, as contracting the multiply-adds would change the results.
+ */
+
+
+__attribute__((target("sse2")))
+static int
+rgb_to_xyz_line_sse2 (
+	uint16_t const * p,
+	int width,
+	double const * lut_in,
+	double const * lut_out,
+	double const * matrix,
+	int* xyz_x,
+	int* xyz_y,
+	int* xyz_z
+	)
+{
+	__m128d m[9];
+	for (int i = 0; i < 9; ++i) {
+		m[i] = _mm_set1_pd (matrix[i]);
+	}
+
+	auto const zero = _mm_setzero_pd ();
+	auto const limit = _mm_set1_pd (65535);
+	auto const scale = _mm_set1_pd (4095);
+
+	int clamped = 0;
+	int x = 0;
+
+	for (; x + 2 <= width; x += 2) {
+		auto const r = _mm_set_pd (lut_in[p[3] >> 4], lut_in[p[0] >> 4]);
+		auto const g = _mm_set_pd (lut_in[p[4] >> 4], lut_in[p[1] >> 4]);
+		auto const b = _mm_set_pd (lut_in[p[5] >> 4], lut_in[p[2] >> 4]);
+		p += 6;
+
+		auto dx = _mm_add_pd (_mm_add_pd (_mm_mul_pd (r, m[0]), _mm_mul_pd (g, m[1])), _mm_mul_pd (b, m[2]));
+		auto dy = _mm_add_pd (_mm_add_pd (_mm_mul_pd (r, m[3]), _mm_mul_pd (g, m[4])), _mm_mul_pd (b, m[5]));
+		auto dz = _mm_add_pd (_mm_add_pd (_mm_mul_pd (r, m[6]), _mm_mul_pd (g, m[7])), _mm_mul_pd (b, m[8]));
+
+		auto const out_of_range = _mm_or_pd (
+			_mm_or_pd (
+				_mm_or_pd (_mm_cmplt_pd (dx, zero), _mm_cmpgt_pd (dx, limit)),
+				_mm_or_pd (_mm_cmplt_pd (dy, zero), _mm_cmpgt_pd (dy, limit))
+				),
+			_mm_or_pd (_mm_cmplt_pd (dz, zero), _mm_cmpgt_pd (dz, limit))
+			);
+		clamped += __builtin_popcount (_mm_movemask_pd (out_of_range));
+
+		dx = _mm_min_pd (_mm_max_pd (dx, zero), limit);
+		dy = _mm_min_pd (_mm_max_pd (dy, zero), limit);
+		dz = _mm_min_pd (_mm_max_pd (dz, zero), limit);
+
+		int ix[4];
+		int iy[4];
+		int iz[4];
+		_mm_storeu_si128 (reinterpret_cast<__m128i*>(ix), _mm_cvtpd_epi32(dx));
+		_mm_storeu_si128 (reinterpret_cast<__m128i*>(iy), _mm_cvtpd_epi32(dy));
+		_mm_storeu_si128 (reinterpret_cast<__m128i*>(iz), _mm_cvtpd_epi32(dz));
+
+		_mm_storel_epi64 (reinterpret_cast<__m128i*>(xyz_x), _mm_cvtpd_epi32(_mm_mul_pd(_mm_set_pd(lut_out[ix[1]], lut_out[ix[0]]), scale)));
+		_mm_storel_epi64 (reinterpret_cast<__m128i*>(xyz_y), _mm_cvtpd_epi32(_mm_mul_pd(_mm_set_pd(lut_out[iy[1]], lut_out[iy[0]]), scale)));
+		_mm_storel_epi64 (reinterpret_cast<__m128i*>(xyz_z), _mm_cvtpd_epi32(_mm_mul_pd(_mm_set_pd(lut_out[iz[1]], lut_out[iz[0]]), scale)));
+		xyz_x += 2;
+		xyz_y += 2;
+		xyz_z += 2;
+	}
+
+	return clamped + rgb_to_xyz_line_scalar (p, width - x, lut_in, lut_out, matrix, xyz_x, xyz_y, xyz_z);
+}
+
+
+__attribute__((target("avx2")))
+static int
+rgb_to_xyz_line_avx2 (
+	uint16_t const * p,
+	int width,
+	double const * lut_in,
+	double const * lut_out,
+	double const * matrix,
+	int* xyz_x,
+	int* xyz_y,
+	int* xyz_z
+	)
+{
+	__m256d m[9];
+	for (int i = 0; i < 9; ++i) {
+		m[i] = _mm256_set1_pd (matrix[i]);
+	}
+
+	auto const zero = _mm256_setzero_pd ();
+	auto const limit = _mm256_set1_pd (65535);
+	auto const scale = _mm256_set1_pd (4095);
+
+	int clamped = 0;
+	int x = 0;
+
+	for (; x + 4 <= width; x += 4) {
+		auto const r = _mm256_i32gather_pd (lut_in, _mm_set_epi32(p[9] >> 4, p[6] >> 4, p[3] >> 4, p[0] >> 4), 8);
+		auto const g = _mm256_i32gather_pd (lut_in, _mm_set_epi32(p[10] >> 4, p[7] >> 4, p[4] >> 4, p[1] >> 4), 8);
+		auto const b = _mm256_i32gather_pd (lut_in, _mm_set_epi32(p[11] >> 4, p[8] >> 4, p[5] >> 4, p[2] >> 4), 8);
+		p += 12;
+
+		auto dx = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (r, m[0]), _mm256_mul_pd (g, m[1])), _mm256_mul_pd (b, m[2]));
+		auto dy = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (r, m[3]), _mm256_mul_pd (g, m[4])), _mm256_mul_pd (b, m[5]));
+		auto dz = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (r, m[6]), _mm256_mul_pd (g, m[7])), _mm256_mul_pd (b, m[8]));
+
+		auto const out_of_range = _mm256_or_pd (
+			_mm256_or_pd (
+				_mm256_or_pd (_mm256_cmp_pd (dx, zero, _CMP_LT_OQ), _mm256_cmp_pd (dx, limit, _CMP_GT_OQ)),
+				_mm256_or_pd (_mm256_cmp_pd (dy, zero, _CMP_LT_OQ), _mm256_cmp_pd (dy, limit, _CMP_GT_OQ))
+				),
+			_mm256_or_pd (_mm256_cmp_pd (dz, zero, _CMP_LT_OQ), _mm256_cmp_pd (dz, limit, _CMP_GT_OQ))
+			);
+		clamped += __builtin_popcount (_mm256_movemask_pd (out_of_range));
+
+		dx = _mm256_min_pd (_mm256_max_pd (dx, zero), limit);
+		dy = _mm256_min_pd (_mm256_max_pd (dy, zero), limit);
+		dz = _mm256_min_pd (_mm256_max_pd (dz, zero), limit);
+
+		_mm_storeu_si128 (reinterpret_cast<__m128i*>(xyz_x), _mm256_cvtpd_epi32(_mm256_mul_pd(_mm256_i32gather_pd(lut_out, _mm256_cvtpd_epi32(dx), 8), scale)));
+		_mm_storeu_si128 (reinterpret_cast<__m128i*>(xyz_y), _mm256_cvtpd_epi32(_mm256_mul_pd(_mm256_i32gather_pd(lut_out, _mm256_cvtpd_epi32(dy), 8), scale)));
+		_mm_storeu_si128 (reinterpret_cast<__m128i*>(xyz_z), _mm256_cvtpd_epi32(_mm256_mul_pd(_mm256_i32gather_pd(lut_out, _mm256_cvtpd_epi32(dz), 8), scale)));
+		xyz_x += 4;
+		xyz_y += 4;
+		xyz_z += 4;
+	}
+
+	return clamped + rgb_to_xyz_line_scalar (p, width - x, lut_in, lut_out, matrix, xyz_x, xyz_y, xyz_z);
+}
+
+
+#endif
+
+
+RGBToXYZKernel
+dcp::best_rgb_to_xyz_kernel ()
+{
+#ifdef LIBDCP_X86_KERNELS
+	if (__builtin_cpu_supports("avx2")) {
+		return RGBToXYZKernel::AVX2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return RGBToXYZKernel::SSE2;
+	}
+#endif
+	return RGBToXYZKernel::SCALAR;
+}
+
+
 shared_ptr<dcp::OpenJPEGImage>
 dcp::rgb_to_xyz (
 	uint8_t const * rgb,
@@ -266,15 +729,50 @@ dcp::rgb_to_xyz (
 	optional<NoteHandler> note
 	)
 {
-	auto xyz = make_shared<OpenJPEGImage>(size);
+	return rgb_to_xyz (rgb, size, stride, conversion, best_rgb_to_xyz_kernel(), 1, note);
+}
 
-	struct {
-		double r, g, b;
-	} s;
 
-	struct {
-		double x, y, z;
-	} d;
+shared_ptr<dcp::OpenJPEGImage>
+dcp::rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	ColourConversion const & conversion,
+	int threads,
+	optional<NoteHandler> note
+	)
+{
+	return rgb_to_xyz (rgb, size, stride, conversion, best_rgb_to_xyz_kernel(), threads, note);
+}
+
+
+shared_ptr<dcp::OpenJPEGImage>
+dcp::rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	ColourConversion const & conversion,
+	RGBToXYZKernel kernel,
+	optional<NoteHandler> note
+	)
+{
+	return rgb_to_xyz (rgb, size, stride, conversion, kernel, 1, note);
+}
+
+
+shared_ptr<dcp::OpenJPEGImage>
+dcp::rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	ColourConversion const & conversion,
+	RGBToXYZKernel kernel,
+	int threads,
+	optional<NoteHandler> note
+	)
+{
+	auto xyz = make_shared<OpenJPEGImage>(size);
 
 	auto const * lut_in = conversion.in()->lut (12, false);
 	auto const * lut_out = conversion.out()->lut (16, true);
@@ -283,46 +781,94 @@ dcp::rgb_to_xyz (
 	double fast_matrix[9];
 	combined_rgb_to_xyz (conversion, fast_matrix);
 
-	int clamped = 0;
-	int* xyz_x = xyz->data (0);
-	int* xyz_y = xyz->data (1);
-	int* xyz_z = xyz->data (2);
-	for (int y = 0; y < size.height; ++y) {
-		auto p = reinterpret_cast<uint16_t const *> (rgb + y * stride);
-		for (int x = 0; x < size.width; ++x) {
-
-			/* In gamma LUT (converting 16-bit to 12-bit) */
-			s.r = lut_in[*p++ >> 4];
-			s.g = lut_in[*p++ >> 4];
-			s.b = lut_in[*p++ >> 4];
-
-			/* RGB to XYZ, Bradford transform and DCI companding */
-			d.x = s.r * fast_matrix[0] + s.g * fast_matrix[1] + s.b * fast_matrix[2];
-			d.y = s.r * fast_matrix[3] + s.g * fast_matrix[4] + s.b * fast_matrix[5];
-			d.z = s.r * fast_matrix[6] + s.g * fast_matrix[7] + s.b * fast_matrix[8];
-
-			/* Clamp */
-
-			if (d.x < 0 || d.y < 0 || d.z < 0 || d.x > 65535 || d.y > 65535 || d.z > 65535) {
-				++clamped;
-			}
+	DCP_ASSERT (kernel <= best_rgb_to_xyz_kernel());
+
+	auto line = &rgb_to_xyz_line_scalar;
+#ifdef LIBDCP_X86_KERNELS
+	switch (kernel) {
+	case RGBToXYZKernel::SCALAR:
+		break;
+	case RGBToXYZKernel::SSE2:
+		line = &rgb_to_xyz_line_sse2;
+		break;
+	case RGBToXYZKernel::AVX2:
+		line = &rgb_to_xyz_line_avx2;
+		break;
+	}
+#endif
+
+	/* Clamp counts for each band, added up afterwards */
+	vector<int> clamped (max(1, threads));
+
+	for_each_band (size.height, threads, [&](int band, int start, int end) {
+		int band_clamped = 0;
+		for (int y = start; y < end; ++y) {
+			band_clamped += line (
+				reinterpret_cast<uint16_t const *>(rgb + y * stride),
+				size.width,
+				lut_in,
+				lut_out,
+				fast_matrix,
+				xyz->data(0) + y * size.width,
+				xyz->data(1) + y * size.width,
+				xyz->data(2) + y * size.width
+				);
+		}
+		clamped[band] = band_clamped;
+	});
+
+	int const total_clamped = std::accumulate (clamped.begin(), clamped.end(), 0);
+	if (total_clamped && note) {
+		note.get()(NoteType::NOTE, String::compose("%1 XYZ value(s) clamped", total_clamped));
+	}
 
-			d.x = max (0.0, d.x);
-			d.y = max (0.0, d.y);
-			d.z = max (0.0, d.z);
-			d.x = min (65535.0, d.x);
-			d.y = min (65535.0, d.y);
-			d.z = min (65535.0, d.z);
+	return xyz;
+}
 
-			/* Out gamma LUT */
-			*xyz_x++ = lrint (lut_out[lrint(d.x)] * 4095);
-			*xyz_y++ = lrint (lut_out[lrint(d.y)] * 4095);
-			*xyz_z++ = lrint (lut_out[lrint(d.z)] * 4095);
+
+shared_ptr<dcp::OpenJPEGImage>
+dcp::rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	FixedPointColourConversion const & conversion,
+	int threads,
+	optional<NoteHandler> note
+	)
+{
+	auto xyz = make_shared<OpenJPEGImage>(size);
+
+	auto const lut_in = conversion.rgb_to_xyz_in ();
+	auto const matrix = conversion.rgb_to_xyz_matrix ();
+	auto const lut_out = conversion.rgb_to_xyz_out ();
+
+	vector<int> clamped (max(1, threads));
+
+	for_each_band (size.height, threads, [&](int band, int start, int end) {
+		int* xyz_x = xyz->data(0) + start * size.width;
+		int* xyz_y = xyz->data(1) + start * size.width;
+		int* xyz_z = xyz->data(2) + start * size.width;
+		int band_clamped = 0;
+		for (int y = start; y < end; ++y) {
+			auto p = reinterpret_cast<uint16_t const *> (rgb + y * stride);
+			for (int x = 0; x < size.width; ++x) {
+				int64_t const sr = lut_in[*p++ >> 4];
+				int64_t const sg = lut_in[*p++ >> 4];
+				int64_t const sb = lut_in[*p++ >> 4];
+				/* Count pixels, rather than components, that were clamped, as the exact conversion does */
+				int pixel_clamped = 0;
+				*xyz_x++ = lut_out[fixed_point_row(matrix + 0, sr, sg, sb, pixel_clamped)];
+				*xyz_y++ = lut_out[fixed_point_row(matrix + 3, sr, sg, sb, pixel_clamped)];
+				*xyz_z++ = lut_out[fixed_point_row(matrix + 6, sr, sg, sb, pixel_clamped)];
+				band_clamped += pixel_clamped;
+			}
 		}
-	}
+		clamped[band] = band_clamped;
+	});
 
-	if (clamped && note) {
-		note.get()(NoteType::NOTE, String::compose("%1 XYZ value(s) clamped", clamped));
+	int const total_clamped = std::accumulate (clamped.begin(), clamped.end(), 0);
+	if (total_clamped && note) {
+		note.get()(NoteType::NOTE, String::compose("%1 XYZ value(s) clamped", total_clamped));
 	}
 
 	return xyz;
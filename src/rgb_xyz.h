@@ -49,6 +49,7 @@ namespace dcp {
 class OpenJPEGImage;
 class Image;
 class ColourConversion;
+class FixedPointColourConversion;
 
 
 /** Convert an XYZ image to RGBA.
@@ -74,6 +75,18 @@ extern void xyz_to_rgba (
 	);
 
 
+/** As above, but splitting the image into bands of lines which are converted in parallel.
+ *  @param threads Number of threads to use (including the calling thread).
+ */
+extern void xyz_to_rgba (
+	std::shared_ptr<const OpenJPEGImage>,
+	ColourConversion const & conversion,
+	uint8_t* rgba,
+	int stride,
+	int threads
+	);
+
+
 /** Convert an XYZ image to 48bpp RGB.
  *  @param xyz_image Frame in XYZ.
  *  @param conversion Colour conversion to use.
@@ -92,6 +105,35 @@ extern void xyz_to_rgb (
 	);
 
 
+/** As above, but splitting the image into bands of lines which are converted in parallel.
+ *  Any notes are made on the calling thread, in the same order as the single-threaded version.
+ *  @param threads Number of threads to use (including the calling thread).
+ */
+extern void xyz_to_rgb (
+	std::shared_ptr<const OpenJPEGImage>,
+	ColourConversion const & conversion,
+	uint8_t* rgb,
+	int stride,
+	int threads,
+	boost::optional<NoteHandler> note = boost::optional<NoteHandler> ()
+	);
+
+
+/** Implementations of rgb_to_xyz, in order of preference.  All of them
+ *  give exactly the same results.
+ */
+enum class RGBToXYZKernel
+{
+	SCALAR, ///< plain C++, one pixel at a time
+	SSE2,   ///< 2 pixels at a time using SSE2
+	AVX2    ///< 4 pixels at a time using AVX2, with gathers for the LUT lookups
+};
+
+
+/** @return The fastest rgb_to_xyz kernel that the CPU we are running on supports */
+extern RGBToXYZKernel best_rgb_to_xyz_kernel ();
+
+
 /** @param rgb RGB data; packed RGB 16:16:16, 48bpp, 16R, 16G, 16B,
  *  with the 2-byte value for each R/G/B component stored as
  *  little-endian; i.e. AV_PIX_FMT_RGB48LE.
@@ -107,6 +149,85 @@ extern std::shared_ptr<OpenJPEGImage> rgb_to_xyz (
 	);
 
 
+/** As above, but splitting the image into bands of lines which are converted in parallel.
+ *  @param threads Number of threads to use (including the calling thread).
+ */
+extern std::shared_ptr<OpenJPEGImage> rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	ColourConversion const & conversion,
+	int threads,
+	boost::optional<NoteHandler> note = boost::optional<NoteHandler> ()
+	);
+
+
+/** As above, but using a particular kernel rather than the best one for this CPU.
+ *  @param kernel Kernel to use; must not be better than best_rgb_to_xyz_kernel().
+ */
+extern std::shared_ptr<OpenJPEGImage> rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	ColourConversion const & conversion,
+	RGBToXYZKernel kernel,
+	boost::optional<NoteHandler> note = boost::optional<NoteHandler> ()
+	);
+
+
+extern std::shared_ptr<OpenJPEGImage> rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	ColourConversion const & conversion,
+	RGBToXYZKernel kernel,
+	int threads,
+	boost::optional<NoteHandler> note = boost::optional<NoteHandler> ()
+	);
+
+
+/** Convert an XYZ image to RGBA using integer arithmetic; this is faster than the version
+ *  which takes a ColourConversion, and the results differ from it only very slightly.
+ *  Out-of-range XYZ values are clamped.
+ *  @param threads Number of threads to use (including the calling thread).
+ */
+extern void xyz_to_rgba (
+	std::shared_ptr<const OpenJPEGImage>,
+	FixedPointColourConversion const & conversion,
+	uint8_t* rgba,
+	int stride,
+	int threads = 1
+	);
+
+
+/** Convert an XYZ image to 48bpp RGB using integer arithmetic; this is faster than the version
+ *  which takes a ColourConversion, and the results differ from it only very slightly.
+ *  Out-of-range XYZ values are clamped without any note being made.
+ *  @param threads Number of threads to use (including the calling thread).
+ */
+extern void xyz_to_rgb (
+	std::shared_ptr<const OpenJPEGImage>,
+	FixedPointColourConversion const & conversion,
+	uint8_t* rgb,
+	int stride,
+	int threads = 1
+	);
+
+
+/** Convert 48bpp RGB to XYZ using integer arithmetic; this is faster than the versions
+ *  which take a ColourConversion, and the results differ from them only very slightly.
+ *  @param threads Number of threads to use (including the calling thread).
+ */
+extern std::shared_ptr<OpenJPEGImage> rgb_to_xyz (
+	uint8_t const * rgb,
+	dcp::Size size,
+	int stride,
+	FixedPointColourConversion const & conversion,
+	int threads = 1,
+	boost::optional<NoteHandler> note = boost::optional<NoteHandler> ()
+	);
+
+
 /** @param conversion Colour conversion.
  *  @param matrix Filled in with the product of the RGB to XYZ matrix, the Bradford transform and the DCI companding.
  */
@@ -32,21 +32,52 @@
 */
 
 
+#include "asset_index.h"
+#include "cpl.h"
 #include "dcp.h"
+#include "dcp_cache.h"
 #include "decrypted_kdm.h"
 #include "exceptions.h"
+#include "interop_subtitle_asset.h"
+#include "reel_file_asset.h"
 #include "search.h"
 
 
+using std::dynamic_pointer_cast;
 using std::make_shared;
 using std::shared_ptr;
 using std::vector;
 using namespace dcp;
 
 
-/** Find all the CPLs in some directories and resolve any assets that are found */
+/** Add a DCP's CPLs and the assets that they refer to to an index, without making any
+ *  assets which were read lazily and have not yet been needed.
+ */
+static void
+add_assets (AssetIndex& index, shared_ptr<const dcp::DCP> dcp)
+{
+	for (auto cpl: dcp->cpls()) {
+		index.add (cpl);
+		for (auto i: cpl->reel_file_assets()) {
+			auto const& ref = i->asset_ref();
+			if (auto lazy = ref.lazy_asset()) {
+				index.add (lazy);
+			} else if (ref.resolved()) {
+				index.add (ref.asset());
+				/* More Interop special-casing */
+				if (auto sub = dynamic_pointer_cast<InteropSubtitleAsset>(ref.asset())) {
+					vector<shared_ptr<Asset>> fonts;
+					sub->add_font_assets (fonts);
+					index.add (fonts);
+				}
+			}
+		}
+	}
+}
+
+
 vector<shared_ptr<dcp::CPL>>
-dcp::find_and_resolve_cpls (vector<boost::filesystem::path> const& directories, bool tolerant)
+dcp::find_and_resolve_cpls (vector<boost::filesystem::path> const& directories, bool tolerant, DCPCache* cache)
 {
 	vector<shared_ptr<dcp::CPL>> cpls;
 
@@ -59,9 +90,14 @@ dcp::find_and_resolve_cpls (vector<boost::filesystem::path> const& directories,
 
 	vector<shared_ptr<dcp::DCP>> dcps;
 	for (auto i: directories) {
-		auto dcp = make_shared<dcp::DCP>(i);
 		vector<dcp::VerificationNote> notes;
-		dcp->read (&notes, true);
+		shared_ptr<dcp::DCP> dcp;
+		if (cache) {
+			dcp = cache->read (i, &notes, true);
+		} else {
+			dcp = make_shared<dcp::DCP>(i);
+			dcp->read (&notes, true);
+		}
 		if (!tolerant) {
 			for (auto j: notes) {
 				if (std::find(ignore.begin(), ignore.end(), j.code()) == ignore.end()) {
@@ -75,12 +111,14 @@ dcp::find_and_resolve_cpls (vector<boost::filesystem::path> const& directories,
 		}
 	}
 
+	/* Resolve every DCP's references using the assets of all the DCPs (such as a VF's references to its OV) */
+	AssetIndex assets;
 	for (auto i: dcps) {
-		for (auto j: dcps) {
-			if (i != j) {
-				i->resolve_refs(j->assets(true));
-			}
-		}
+		add_assets (assets, i);
+	}
+
+	for (auto i: dcps) {
+		i->resolve_refs (assets);
 	}
 
 	return cpls;
@@ -34,7 +34,15 @@
 
 namespace dcp {
 
-extern std::vector<std::shared_ptr<dcp::CPL>> find_and_resolve_cpls (std::vector<boost::filesystem::path> const& directories, bool tolerant);
+class DCPCache;
+
+/** Find all the CPLs in some directories and resolve any assets that are found.
+ *  @param cache Cache to read the DCPs through, or nullptr.  The same checks are made on the DCPs either way,
+ *  as a DCP is read in full whenever the cache does not have an up-to-date snapshot of it (see DCPCache).
+ */
+extern std::vector<std::shared_ptr<dcp::CPL>> find_and_resolve_cpls (
+	std::vector<boost::filesystem::path> const& directories, bool tolerant, DCPCache* cache = nullptr
+	);
 
 }
 
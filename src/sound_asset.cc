@@ -233,7 +233,7 @@ SoundAsset::start_write (boost::filesystem::path file, bool atmos_sync)
 shared_ptr<SoundAssetReader>
 SoundAsset::start_read () const
 {
-	return shared_ptr<SoundAssetReader> (new SoundAssetReader(this, key(), standard()));
+	return shared_ptr<SoundAssetReader> (new SoundAssetReader(this, key(), standard(), intrinsic_duration()));
 }
 
 
@@ -46,8 +46,14 @@ using std::cout;
 using namespace dcp;
 
 
-SoundFrame::SoundFrame (ASDCP::PCM::MXFReader* reader, int n, std::shared_ptr<const DecryptionContext> c, bool check_hmac)
-	: Frame<ASDCP::PCM::MXFReader, ASDCP::PCM::FrameBuffer> (reader, n, c, check_hmac)
+SoundFrame::SoundFrame (
+	ASDCP::PCM::MXFReader* reader,
+	int n,
+	std::shared_ptr<const DecryptionContext> c,
+	bool check_hmac,
+	std::shared_ptr<FrameBufferPool<ASDCP::PCM::FrameBuffer>> pool
+	)
+	: Frame<ASDCP::PCM::MXFReader, ASDCP::PCM::FrameBuffer> (reader, n, c, check_hmac, pool)
 {
 	ASDCP::PCM::AudioDescriptor desc;
 	reader->FillAudioDescriptor (desc);
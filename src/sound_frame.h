@@ -51,7 +51,13 @@ namespace dcp {
 class SoundFrame : public Frame<ASDCP::PCM::MXFReader, ASDCP::PCM::FrameBuffer>
 {
 public:
-	SoundFrame (ASDCP::PCM::MXFReader* reader, int n, std::shared_ptr<const DecryptionContext> c, bool check_hmac);
+	SoundFrame (
+		ASDCP::PCM::MXFReader* reader,
+		int n,
+		std::shared_ptr<const DecryptionContext> c,
+		bool check_hmac,
+		std::shared_ptr<FrameBufferPool<ASDCP::PCM::FrameBuffer>> pool = nullptr
+		);
 	int channels () const;
 	int samples () const;
 	int32_t get (int channel, int sample) const;
@@ -94,9 +94,15 @@ StereoPictureAsset::start_write (boost::filesystem::path file, bool overwrite)
 
 
 shared_ptr<StereoPictureAssetReader>
-StereoPictureAsset::start_read () const
+StereoPictureAsset::start_read (bool map) const
 {
-	return shared_ptr<StereoPictureAssetReader> (new StereoPictureAssetReader(this, key(), standard()));
+	auto reader = shared_ptr<StereoPictureAssetReader> (new StereoPictureAssetReader(this, key(), standard(), intrinsic_duration()));
+	if (map) {
+		if (auto essence = map_essence()) {
+			reader->map (essence);
+		}
+	}
+	return reader;
 }
 
 
@@ -59,7 +59,10 @@ public:
 
 	/** Start a progressive write to a StereoPictureAsset */
 	std::shared_ptr<PictureAssetWriter> start_write (boost::filesystem::path file, bool) override;
-	std::shared_ptr<StereoPictureAssetReader> start_read () const;
+	/** @param map true to make the reader return frames which point straight into a memory-mapped
+	 *  copy of the MXF; see MonoPictureAsset::start_read().
+	 */
+	std::shared_ptr<StereoPictureAssetReader> start_read (bool map = false) const;
 
 	bool equals (
 		std::shared_ptr<const Asset> other,
@@ -110,7 +110,9 @@ StereoPictureAssetWriter::write (uint8_t const * data, int size)
 		++_frames_written;
 	}
 
-	return FrameInfo (before_offset, _state->mxf_writer.Tell() - before_offset, hash);
+	FrameInfo info (before_offset, _state->mxf_writer.Tell() - before_offset, hash);
+	add_to_frame_index (info, size);
+	return info;
 }
 
 
@@ -125,6 +127,8 @@ StereoPictureAssetWriter::fake_write (int size)
 		boost::throw_exception (MXFFileError("error in writing video MXF", _file.string(), r));
 	}
 
+	_frame_index_complete = false;
+
 	_next_eye = _next_eye == Eye::LEFT ? Eye::RIGHT : Eye::LEFT;
 	if (_next_eye == Eye::LEFT) {
 		++_frames_written;
@@ -42,6 +42,7 @@
 #include "crypto_context.h"
 #include "exceptions.h"
 #include "j2k_transcode.h"
+#include "mapped_essence.h"
 #include "rgb_xyz.h"
 #include "stereo_picture_frame.h"
 #include "util.h"
@@ -55,6 +56,9 @@ using std::make_shared;
 using namespace dcp;
 
 
+int constexpr StereoPictureFrame::initial_buffer_capacity;
+
+
 StereoPictureFrame::Part::Part (shared_ptr<ASDCP::JP2K::SFrameBuffer> buffer, Eye eye)
 	: _buffer (buffer)
 	, _eye (eye)
@@ -95,21 +99,44 @@ StereoPictureFrame::Part::size () const
  *  @param reader Reader for the MXF file.
  *  @param n Frame within the asset, not taking EntryPoint into account.
  *  @param check_hmac true to check the HMAC and give an error if it is not as expected.
+ *  @param pool Pool to take our buffer from.
  */
-StereoPictureFrame::StereoPictureFrame (ASDCP::JP2K::MXFSReader* reader, int n, shared_ptr<DecryptionContext> c, bool check_hmac)
+StereoPictureFrame::StereoPictureFrame (
+	ASDCP::JP2K::MXFSReader* reader,
+	int n,
+	shared_ptr<DecryptionContext> c,
+	bool check_hmac,
+	shared_ptr<FrameBufferPool<Buffer>> pool
+	)
 {
-	/* XXX: unfortunate guesswork on this buffer size */
-	_buffer = make_shared<ASDCP::JP2K::SFrameBuffer>(4 * Kumu::Megabyte);
-
-	if (ASDCP_FAILURE (reader->ReadFrame (n, *_buffer, c->context(), check_hmac ? c->hmac() : nullptr))) {
+	if (ASDCP_FAILURE (pool->read(reader, n, *c, check_hmac, _buffer))) {
 		boost::throw_exception (ReadError (String::compose ("could not read video frame %1 of %2", n)));
 	}
 }
 
 
+/** Make a picture frame whose data is part of some mapped essence, without copying it.
+ *  @param essence Mapped essence of a 3D asset.
+ *  @param n Frame within the asset, not taking EntryPoint into account.
+ */
+StereoPictureFrame::StereoPictureFrame (shared_ptr<const MappedEssence> essence, int n)
+{
+	/* The index has the left eye then the right eye of each frame */
+	auto const left = essence->get (int64_t(n) * 2);
+	auto const right = essence->get (int64_t(n) * 2 + 1);
+
+	/* The buffers do not own the data, and they keep the mapping alive for as long as they are around */
+	_buffer.reset (new ASDCP::JP2K::SFrameBuffer(0), [essence](ASDCP::JP2K::SFrameBuffer* buffer) { delete buffer; });
+	_buffer->Left.SetData (const_cast<uint8_t*>(left.data), left.size);
+	_buffer->Left.Size (left.size);
+	_buffer->Right.SetData (const_cast<uint8_t*>(right.data), right.size);
+	_buffer->Right.Size (right.size);
+}
+
+
 StereoPictureFrame::StereoPictureFrame ()
 {
-	_buffer = make_shared<ASDCP::JP2K::SFrameBuffer>(4 * Kumu::Megabyte);
+	_buffer = make_shared<ASDCP::JP2K::SFrameBuffer>(initial_buffer_capacity);
 }
 
 
@@ -132,6 +159,25 @@ StereoPictureFrame::xyz_image (Eye eye, int reduce) const
 }
 
 
+#ifndef LIBDCP_OPENJPEG1
+/** @param eye Eye to return (EYE_LEFT or EYE_RIGHT).
+ *  @param decoder Decoder to use; this can be kept between frames to avoid setting it up for each one.
+ */
+shared_ptr<OpenJPEGImage>
+StereoPictureFrame::xyz_image (Eye eye, J2KDecoder& decoder) const
+{
+	switch (eye) {
+	case Eye::LEFT:
+		return decoder.decode (_buffer->Left.RoData(), _buffer->Left.Size());
+	case Eye::RIGHT:
+		return decoder.decode (_buffer->Right.RoData(), _buffer->Right.Size());
+	}
+
+	return {};
+}
+#endif
+
+
 shared_ptr<StereoPictureFrame::Part>
 StereoPictureFrame::right () const
 {
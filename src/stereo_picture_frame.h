@@ -43,6 +43,7 @@
 
 #include "types.h"
 #include "asset_reader.h"
+#include "frame_buffer_pool.h"
 #include <memory>
 #include <boost/filesystem.hpp>
 #include <stdint.h>
@@ -61,6 +62,8 @@ namespace ASDCP {
 namespace dcp {
 
 
+class J2KDecoder;
+class MappedEssence;
 class OpenJPEGImage;
 class StereoPictureFrame;
 
@@ -71,12 +74,20 @@ class StereoPictureFrame;
 class StereoPictureFrame
 {
 public:
+	typedef ASDCP::JP2K::SFrameBuffer Buffer;
+
+	/** XXX: unfortunate guesswork on this buffer size */
+	static int constexpr initial_buffer_capacity = 4 * Kumu::Megabyte;
+
 	StereoPictureFrame ();
 
 	StereoPictureFrame (StereoPictureFrame const &) = delete;
 	StereoPictureFrame& operator= (StereoPictureFrame const &) = delete;
 
 	std::shared_ptr<OpenJPEGImage> xyz_image (Eye eye, int reduce = 0) const;
+#ifndef LIBDCP_OPENJPEG1
+	std::shared_ptr<OpenJPEGImage> xyz_image (Eye eye, J2KDecoder& decoder) const;
+#endif
 
 	class Part : public Data
 	{
@@ -105,7 +116,15 @@ private:
 	*/
 	friend class AssetReader<ASDCP::JP2K::MXFSReader, StereoPictureFrame>;
 
-	StereoPictureFrame (ASDCP::JP2K::MXFSReader* reader, int n, std::shared_ptr<DecryptionContext>, bool check_hmac);
+	StereoPictureFrame (
+		ASDCP::JP2K::MXFSReader* reader,
+		int n,
+		std::shared_ptr<DecryptionContext>,
+		bool check_hmac,
+		std::shared_ptr<FrameBufferPool<Buffer>> pool
+		);
+
+	StereoPictureFrame (std::shared_ptr<const MappedEssence> essence, int n);
 
 	std::shared_ptr<ASDCP::JP2K::SFrameBuffer> _buffer;
 };
@@ -42,7 +42,7 @@
 
 
 #include <boost/thread/mutex.hpp>
-#include <map>
+#include <atomic>
 #include <memory>
 
 
@@ -62,7 +62,10 @@ public:
 
 	virtual ~TransferFunction ();
 
-	/** @return A look-up table (of size 2^bit_depth) whose values range from 0 to 1 */
+	/** @return A look-up table (of size 2^bit_depth) whose values range from 0 to 1.
+	 *  Once a given table has been made, getting it again does not take any locks,
+	 *  so this can be called freely from many threads.
+	 */
 	double const * lut (int bit_depth, bool inverse) const;
 
 	virtual bool about_equal (std::shared_ptr<const TransferFunction> other, double epsilon) const = 0;
@@ -72,8 +75,13 @@ protected:
 	virtual double * make_lut (int bit_depth, bool inverse) const = 0;
 
 private:
-	mutable std::map<std::pair<int, bool>, double*> _luts;
-	/** mutex to protect _luts */
+	static int constexpr max_bit_depth = 31;
+
+	/** LUTs indexed by [bit_depth][inverse]; each one is set (once) with _mutex held,
+	 *  but can be read without it.
+	 */
+	mutable std::atomic<double*> _luts[max_bit_depth + 1][2] = {};
+	/** mutex to serialise the creation of _luts */
 	mutable boost::mutex _mutex;
 };
 
@@ -61,9 +61,20 @@
 #include <boost/dll/runtime_symbol_info.hpp>
 #endif
 #include <boost/filesystem.hpp>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
+#include <cerrno>
+#include <cstdlib>
+#ifndef LIBDCP_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 using std::string;
@@ -113,8 +124,41 @@ dcp::make_digest (ArrayData data)
 }
 
 
-string
-dcp::make_digest (boost::filesystem::path filename, function<void (float)> progress)
+/** How make_digest() reads files when it is not told; the two settings are kept together
+ *  so that nobody sees one from one call of set_digest_io() and one from another.
+ */
+struct DefaultDigestIO
+{
+	DigestIO io = DigestIO::STANDARD;
+	int block_size = 8 * 1024 * 1024;
+};
+
+static std::mutex default_digest_io_mutex;
+static DefaultDigestIO default_digest_io;
+
+
+void
+dcp::set_digest_io (DigestIO io, int block_size)
+{
+	std::lock_guard<std::mutex> lm (default_digest_io_mutex);
+	default_digest_io.io = io;
+	default_digest_io.block_size = block_size;
+}
+
+
+static string
+finish_digest (SHA_CTX& sha)
+{
+	byte_t byte_buffer[SHA_DIGEST_LENGTH];
+	SHA1_Final (byte_buffer, &sha);
+
+	char digest[64];
+	return Kumu::base64encode (byte_buffer, SHA_DIGEST_LENGTH, digest, 64);
+}
+
+
+static string
+make_digest_standard (boost::filesystem::path filename, function<void (float)> progress)
 {
 	Kumu::FileReader reader;
 	auto r = reader.OpenRead (filename.string().c_str ());
@@ -148,11 +192,234 @@ dcp::make_digest (boost::filesystem::path filename, function<void (float)> progr
 		}
 	}
 
-	byte_t byte_buffer[SHA_DIGEST_LENGTH];
-	SHA1_Final (byte_buffer, &sha);
+	return finish_digest (sha);
+}
 
-	char digest[64];
-	return Kumu::base64encode (byte_buffer, SHA_DIGEST_LENGTH, digest, 64);
+
+#ifndef LIBDCP_WINDOWS
+
+
+/** A file descriptor which is closed when this object is destroyed */
+class FileDescriptor
+{
+public:
+	FileDescriptor (boost::filesystem::path filename, int flags)
+		: _fd (open(filename.string().c_str(), flags))
+	{}
+
+	~FileDescriptor ()
+	{
+		if (_fd >= 0) {
+			close (_fd);
+		}
+	}
+
+	FileDescriptor (FileDescriptor const&) = delete;
+	FileDescriptor& operator= (FileDescriptor const&) = delete;
+
+	int get () const {
+		return _fd;
+	}
+
+private:
+	int _fd;
+};
+
+
+/** Hash a file using large reads, reading the next block on another thread while hashing the current one.
+ *  @param direct true to try to bypass the OS cache altogether; otherwise we ask the OS to drop data from its
+ *  cache once we have hashed it, so that hashing a big file does not push more useful things out.
+ */
+static string
+make_digest_stream (boost::filesystem::path filename, function<void (float)> progress, bool direct, int block_size)
+{
+	/* O_DIRECT needs the buffers, offsets and sizes of reads to be aligned */
+	int const alignment = 4096;
+	block_size = std::max(alignment, block_size - block_size % alignment);
+
+	int flags = O_RDONLY;
+#ifdef LIBDCP_LINUX
+	if (direct) {
+		flags |= O_DIRECT;
+	}
+#endif
+
+	std::unique_ptr<FileDescriptor> fd (new FileDescriptor(filename, flags));
+	if (fd->get() < 0 && flags != O_RDONLY) {
+		/* Some filesystems do not allow O_DIRECT at all */
+		fd.reset (new FileDescriptor(filename, O_RDONLY));
+	}
+	if (fd->get() < 0) {
+		boost::throw_exception (FileError("could not open file to compute digest", filename, errno));
+	}
+
+#ifdef LIBDCP_OSX
+	if (direct) {
+		fcntl (fd->get(), F_NOCACHE, 1);
+	}
+#endif
+#ifdef LIBDCP_LINUX
+	if (!direct) {
+		posix_fadvise (fd->get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+#endif
+
+	struct stat st;
+	if (fstat(fd->get(), &st) != 0) {
+		boost::throw_exception (FileError("could not read file to compute digest", filename, errno));
+	}
+	auto const size = st.st_size;
+
+	std::unique_ptr<uint8_t, decltype(&free)> buffers[2] = {
+		{ nullptr, &free },
+		{ nullptr, &free }
+	};
+	for (auto& i: buffers) {
+		void* buffer = nullptr;
+		if (posix_memalign(&buffer, alignment, block_size) != 0) {
+			throw std::bad_alloc ();
+		}
+		i.reset (reinterpret_cast<uint8_t*>(buffer));
+	}
+
+	/* Read a whole block, or up to the end of the file; @return number of bytes read */
+	auto read_block = [&](uint8_t* buffer) {
+		ssize_t total = 0;
+		while (total < block_size) {
+			auto const r = read (fd->get(), buffer + total, block_size - total);
+			if (r == 0) {
+				break;
+			} else if (r < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+#ifdef LIBDCP_LINUX
+				if (errno == EINVAL && (fcntl(fd->get(), F_GETFL) & O_DIRECT)) {
+					/* This filesystem does not support O_DIRECT, so carry on without it */
+					fcntl (fd->get(), F_SETFL, fcntl(fd->get(), F_GETFL) & ~O_DIRECT);
+					continue;
+				}
+#endif
+				boost::throw_exception (FileError("could not read file to compute digest", filename, errno));
+			}
+			total += r;
+		}
+		return total;
+	};
+
+	SHA_CTX sha;
+	SHA1_Init (&sha);
+
+	int current = 0;
+	auto got = read_block (buffers[current].get());
+	off_t done = 0;
+	while (got > 0) {
+		auto next = std::async (std::launch::async, read_block, buffers[1 - current].get());
+
+		SHA1_Update (&sha, buffers[current].get(), got);
+#ifdef LIBDCP_LINUX
+		if (!direct) {
+			posix_fadvise (fd->get(), done, got, POSIX_FADV_DONTNEED);
+		}
+#endif
+		done += got;
+
+		if (progress) {
+			progress (size > 0 ? float(done) / size : 1);
+		}
+
+		got = next.get ();
+		current = 1 - current;
+	}
+
+	return finish_digest (sha);
+}
+
+
+/** Hash a file by mapping it into memory */
+static string
+make_digest_mmap (boost::filesystem::path filename, function<void (float)> progress, int block_size)
+{
+	FileDescriptor fd (filename, O_RDONLY);
+	if (fd.get() < 0) {
+		boost::throw_exception (FileError("could not open file to compute digest", filename, errno));
+	}
+
+	struct stat st;
+	if (fstat(fd.get(), &st) != 0) {
+		boost::throw_exception (FileError("could not read file to compute digest", filename, errno));
+	}
+
+	if (static_cast<uintmax_t>(st.st_size) > SIZE_MAX) {
+		/* Too big to map on this system */
+		return make_digest_stream (filename, progress, false, block_size);
+	}
+
+	SHA_CTX sha;
+	SHA1_Init (&sha);
+
+	size_t const size = st.st_size;
+	if (size == 0) {
+		return finish_digest (sha);
+	}
+
+	auto data = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+	if (data == MAP_FAILED) {
+		boost::throw_exception (FileError("could not map file to compute digest", filename, errno));
+	}
+
+	madvise (data, size, MADV_SEQUENTIAL);
+
+	auto p = reinterpret_cast<uint8_t const *>(data);
+	for (size_t done = 0; done < size; ) {
+		auto const this_block = std::min(size - done, static_cast<size_t>(block_size));
+		SHA1_Update (&sha, p + done, this_block);
+		done += this_block;
+		if (progress) {
+			progress (float(done) / size);
+		}
+	}
+
+	munmap (data, size);
+	return finish_digest (sha);
+}
+
+
+#endif
+
+
+string
+dcp::make_digest (boost::filesystem::path filename, function<void (float)> progress)
+{
+	DefaultDigestIO settings;
+	{
+		std::lock_guard<std::mutex> lm (default_digest_io_mutex);
+		settings = default_digest_io;
+	}
+	return make_digest (filename, progress, settings.io, settings.block_size);
+}
+
+
+string
+dcp::make_digest (boost::filesystem::path filename, function<void (float)> progress, DigestIO io, int block_size)
+{
+#ifdef LIBDCP_WINDOWS
+	return make_digest_standard (filename, progress);
+#else
+	switch (io) {
+	case DigestIO::STANDARD:
+		return make_digest_standard (filename, progress);
+	case DigestIO::STREAM:
+		return make_digest_stream (filename, progress, false, block_size);
+	case DigestIO::DIRECT:
+		return make_digest_stream (filename, progress, true, block_size);
+	case DigestIO::MMAP:
+		return make_digest_mmap (filename, progress, block_size);
+	}
+
+	DCP_ASSERT (false);
+	return {};
+#endif
 }
 
 
@@ -74,7 +74,30 @@ class OpenJPEGImage;
 
 extern std::string make_uuid ();
 
-/** Create a digest for a file
+/** Ways that make_digest() can read a file */
+enum class DigestIO
+{
+	/** 64KB reads through asdcplib */
+	STANDARD,
+	/** large reads overlapped with the hashing, asking the OS not to keep the file in its cache */
+	STREAM,
+	/** large reads overlapped with the hashing, bypassing the OS cache (with O_DIRECT on Linux
+	 *  or F_NOCACHE on macOS) where the filesystem allows it
+	 */
+	DIRECT,
+	/** map the file into memory */
+	MMAP
+};
+
+/** Set how make_digest() reads files when it is not told; this is used when hashing assets.
+ *  The default is DigestIO::STANDARD.  Everything other than DigestIO::STANDARD is treated as
+ *  DigestIO::STANDARD on Windows.  This may be called while other threads are hashing; each
+ *  hash uses whatever was last set when it starts.
+ *  @param block_size Size of each read, or of the chunks that a mapped file is hashed in, in bytes.
+ */
+extern void set_digest_io (DigestIO io, int block_size = 8 * 1024 * 1024);
+
+/** Create a digest for a file, reading it in the way given to set_digest_io()
  *  @param filename File name
  *  @param progress Optional progress reporting function.  The function will be called
  *  with a progress value between 0 and 1
@@ -82,6 +105,17 @@ extern std::string make_uuid ();
  */
 extern std::string make_digest (boost::filesystem::path filename, boost::function<void (float)>);
 
+/** Create a digest for a file
+ *  @param filename File name
+ *  @param progress Optional progress reporting function.  The function will be called
+ *  with a progress value between 0 and 1
+ *  @param io How to read the file.
+ *  @param block_size Size of each read, or of the chunks that a mapped file is hashed in, in bytes;
+ *  not used for DigestIO::STANDARD.
+ *  @return Digest
+ */
+extern std::string make_digest (boost::filesystem::path filename, boost::function<void (float)> progress, DigestIO io, int block_size = 8 * 1024 * 1024);
+
 extern std::string make_digest (ArrayData data);
 
 /** @param s A string
@@ -41,6 +41,7 @@
 #include "cpl.h"
 #include "dcp.h"
 #include "exceptions.h"
+#include "hash_assets.h"
 #include "interop_subtitle_asset.h"
 #include "mono_picture_asset.h"
 #include "mono_picture_frame.h"
@@ -77,8 +78,14 @@
 #include <xercesc/sax/HandlerBase.hpp>
 #include <xercesc/util/PlatformUtils.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 
@@ -422,47 +429,208 @@ verify_language_tag (string tag, vector<VerificationNote>& notes)
 }
 
 
-static void
-verify_picture_asset (shared_ptr<const ReelFileAsset> reel_file_asset, boost::filesystem::path file, vector<VerificationNote>& notes, function<void (float)> progress)
+/** Results of checking some of the frames of a picture asset */
+struct PictureFrameResults
 {
 	int biggest_frame = 0;
-	auto asset = dynamic_pointer_cast<PictureAsset>(reel_file_asset->asset_ref().asset());
-	auto const duration = asset->intrinsic_duration ();
 
-	auto check_and_add = [&notes](vector<VerificationNote> const& j2k_notes) {
-		for (auto i: j2k_notes) {
-			if (find(notes.begin(), notes.end(), i) == notes.end()) {
-				notes.push_back (i);
-			}
-		}
+	/** A note from verify_j2k, with where it was first seen */
+	struct Note
+	{
+		int64_t frame;
+		/** index of the note in the list of notes from its frame */
+		size_t index;
+		VerificationNote note;
 	};
 
-	if (auto mono_asset = dynamic_pointer_cast<MonoPictureAsset>(reel_file_asset->asset_ref().asset())) {
-		auto reader = mono_asset->start_read ();
-		for (int64_t i = 0; i < duration; ++i) {
-			auto frame = reader->get_frame (i);
-			biggest_frame = max(biggest_frame, frame->size());
-			if (!mono_asset->encrypted() || mono_asset->key()) {
-				vector<VerificationNote> j2k_notes;
-				verify_j2k (frame, j2k_notes);
-				check_and_add (j2k_notes);
+	/** Each different note that was found, in the order that they were found */
+	vector<Note> notes;
+
+	/** Index of the frame that could not be read, if any */
+	int64_t error_frame = 0;
+	std::exception_ptr error;
+};
+
+
+/** Check frames of a picture asset, taking the index of the next one to check from @p next
+ *  until there are none left or @p stop is set.
+ *  @param get_frame Function to read the frame with a given index, returning the data for each of its eyes.
+ *  @param check_j2k true to check the JPEG2000 codestreams, false to only look at the frames' sizes.
+ *  @param frame_done Called after each frame has been checked.
+ */
+static void
+check_picture_frames (
+	function<vector<shared_ptr<const Data>> (int64_t)> get_frame,
+	bool check_j2k,
+	int64_t duration,
+	std::atomic<int64_t>& next,
+	std::atomic<bool>& stop,
+	function<void ()> frame_done,
+	PictureFrameResults& results
+	)
+{
+	int64_t frame = 0;
+	try {
+		while (!stop) {
+			frame = next++;
+			if (frame >= duration) {
+				break;
 			}
-			progress (float(i) / duration);
+
+			vector<VerificationNote> j2k_notes;
+			for (auto i: get_frame(frame)) {
+				results.biggest_frame = max(results.biggest_frame, i->size());
+				if (check_j2k) {
+					verify_j2k (i, j2k_notes);
+				}
+			}
+
+			for (size_t i = 0; i < j2k_notes.size(); ++i) {
+				auto const& note = j2k_notes[i];
+				if (std::find_if(results.notes.begin(), results.notes.end(), [&note](PictureFrameResults::Note const& j) { return j.note == note; }) == results.notes.end()) {
+					results.notes.push_back ({frame, i, note});
+				}
+			}
+
+			frame_done ();
 		}
+	} catch (...) {
+		results.error_frame = frame;
+		results.error = std::current_exception ();
+		stop = true;
+	}
+}
+
+
+static void
+verify_picture_asset (
+	shared_ptr<const ReelFileAsset> reel_file_asset,
+	boost::filesystem::path file,
+	vector<VerificationNote>& notes,
+	function<void (float)> progress,
+	int threads,
+	bool map
+	)
+{
+	auto asset = dynamic_pointer_cast<PictureAsset>(reel_file_asset->asset_ref().asset());
+	auto const duration = asset->intrinsic_duration ();
+
+	/* Make a function to read frames; each thread needs its own, as readers cannot be shared.
+	   The parameter is the number of frames that the reader should read ahead.
+	*/
+	function<function<vector<shared_ptr<const Data>> (int64_t)> (int)> make_get_frame;
+	bool check_j2k = false;
+
+	if (auto mono_asset = dynamic_pointer_cast<MonoPictureAsset>(asset)) {
+		check_j2k = !mono_asset->encrypted() || mono_asset->key();
+		make_get_frame = [mono_asset, map](int prefetch) {
+			auto reader = mono_asset->start_read (map);
+			reader->set_prefetch (prefetch);
+			return [reader](int64_t i) {
+				return vector<shared_ptr<const Data>>{ reader->get_frame(i) };
+			};
+		};
 	} else if (auto stereo_asset = dynamic_pointer_cast<StereoPictureAsset>(asset)) {
-		auto reader = stereo_asset->start_read ();
-		for (int64_t i = 0; i < duration; ++i) {
-			auto frame = reader->get_frame (i);
-			biggest_frame = max(biggest_frame, max(frame->left()->size(), frame->right()->size()));
-			if (!stereo_asset->encrypted() || mono_asset->key()) {
-				vector<VerificationNote> j2k_notes;
-				verify_j2k (frame->left(), j2k_notes);
-				verify_j2k (frame->right(), j2k_notes);
-				check_and_add (j2k_notes);
+		check_j2k = !stereo_asset->encrypted() || stereo_asset->key();
+		make_get_frame = [stereo_asset, map](int prefetch) {
+			auto reader = stereo_asset->start_read (map);
+			reader->set_prefetch (prefetch);
+			return [reader](int64_t i) {
+				auto frame = reader->get_frame (i);
+				return vector<shared_ptr<const Data>>{ frame->left(), frame->right() };
+			};
+		};
+	} else {
+		return;
+	}
+
+	std::atomic<int64_t> next (0);
+	std::atomic<bool> stop (false);
+	threads = static_cast<int>(std::max(int64_t(1), std::min(int64_t(threads), duration)));
+	vector<PictureFrameResults> results (threads);
+
+	if (threads == 1) {
+		int64_t done = 0;
+		/* Frames are checked in order here, so it helps to read the next ones while we check each one */
+		check_picture_frames (make_get_frame(4), check_j2k, duration, next, stop, [&]() { progress(float(done++) / duration); }, results[0]);
+	} else {
+		/* Each worker holds at most one frame at a time, so memory use is bounded by the number
+		   of threads.  Progress is reported from this thread as the workers finish frames.
+		*/
+		std::mutex mutex;
+		std::condition_variable condition;
+		int64_t done = 0;
+		int finished = 0;
+
+		vector<std::thread> workers;
+		for (int i = 0; i < threads; ++i) {
+			workers.push_back (std::thread([&, i]() {
+				auto frame_done = [&]() {
+					std::lock_guard<std::mutex> lm (mutex);
+					++done;
+					condition.notify_one ();
+				};
+				try {
+					/* The workers take frames in turn, so each one's frames are not consecutive and it is no use prefetching */
+					check_picture_frames (make_get_frame(0), check_j2k, duration, next, stop, frame_done, results[i]);
+				} catch (...) {
+					/* make_get_frame() failed to open a reader */
+					results[i].error_frame = 0;
+					results[i].error = std::current_exception ();
+					stop = true;
+				}
+				std::lock_guard<std::mutex> lm (mutex);
+				++finished;
+				condition.notify_one ();
+			}));
+		}
+
+		int64_t reported = 0;
+		std::unique_lock<std::mutex> lm (mutex);
+		while (true) {
+			condition.wait (lm, [&]() { return done > reported || finished == threads; });
+			auto const now = done;
+			auto const all_finished = finished == threads;
+			lm.unlock ();
+			for (; reported < now; ++reported) {
+				progress (float(reported) / duration);
+			}
+			if (all_finished) {
+				break;
 			}
-			progress (float(i) / duration);
+			lm.lock ();
 		}
 
+		for (auto& i: workers) {
+			i.join ();
+		}
+	}
+
+	/* Report the error from the earliest frame, which is the one we would have had without threads */
+	PictureFrameResults const* first_error = nullptr;
+	for (auto const& i: results) {
+		if (i.error && (!first_error || i.error_frame < first_error->error_frame)) {
+			first_error = &i;
+		}
+	}
+	if (first_error) {
+		std::rethrow_exception (first_error->error);
+	}
+
+	/* Merge the notes from all the threads in the order that they would have been found by one thread */
+	vector<PictureFrameResults::Note> all_notes;
+	int biggest_frame = 0;
+	for (auto const& i: results) {
+		biggest_frame = max(biggest_frame, i.biggest_frame);
+		all_notes.insert (all_notes.end(), i.notes.begin(), i.notes.end());
+	}
+	std::stable_sort (all_notes.begin(), all_notes.end(), [](PictureFrameResults::Note const& a, PictureFrameResults::Note const& b) {
+		return a.frame < b.frame || (a.frame == b.frame && a.index < b.index);
+	});
+	for (auto const& i: all_notes) {
+		if (find(notes.begin(), notes.end(), i.note) == notes.end()) {
+			notes.push_back (i.note);
+		}
 	}
 
 	static const int max_frame =   rint(250 * 1000000 / (8 * asset->edit_rate().as_float()));
@@ -479,20 +647,11 @@ verify_picture_asset (shared_ptr<const ReelFileAsset> reel_file_asset, boost::fi
 }
 
 
+/** Add notes for the result of checking a picture asset's hash */
 static void
-verify_main_picture_asset (
-	shared_ptr<const DCP> dcp,
-	shared_ptr<const ReelPictureAsset> reel_asset,
-	function<void (string, optional<boost::filesystem::path>)> stage,
-	function<void (float)> progress,
-	vector<VerificationNote>& notes
-	)
+add_picture_hash_notes (VerifyAssetResult result, boost::filesystem::path file, vector<VerificationNote>& notes)
 {
-	auto asset = reel_asset->asset();
-	auto const file = *asset->file();
-	stage ("Checking picture asset hash", file);
-	auto const r = verify_asset (dcp, reel_asset, progress);
-	switch (r) {
+	switch (result) {
 		case VerifyAssetResult::BAD:
 			notes.push_back ({
 				VerificationNote::Type::ERROR, VerificationNote::Code::INCORRECT_PICTURE_HASH, file
@@ -506,8 +665,108 @@ verify_main_picture_asset (
 		default:
 			break;
 	}
-	stage ("Checking picture frame sizes", asset->file());
-	verify_picture_asset (reel_asset, file, notes, progress);
+}
+
+
+/** Check a picture asset's hash on a separate thread while its frames are checked on this one.
+ *  The hash is stopped from getting more than a little way ahead of the frame checks, so the frames
+ *  are read from the OS cache just after the hash has read them, and the file is only read from
+ *  storage once.
+ */
+static void
+verify_picture_asset_single_pass (
+	shared_ptr<const DCP> dcp,
+	shared_ptr<const ReelPictureAsset> reel_asset,
+	boost::filesystem::path file,
+	function<void (float)> progress,
+	vector<VerificationNote>& notes,
+	int threads,
+	bool map
+	)
+{
+	/* How far (in bytes) the hash may get ahead of the frame checks */
+	int64_t const max_hash_lead = 64 * 1024 * 1024;
+	float const lead = std::min(1.0, double(max_hash_lead) / std::max(uintmax_t(1), boost::filesystem::file_size(file)));
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	float frames_progress = 0;
+	bool frames_finished = false;
+
+	auto finish_frames = [&]() {
+		std::lock_guard<std::mutex> lm (mutex);
+		frames_finished = true;
+		condition.notify_all ();
+	};
+
+	VerifyAssetResult hash_result = VerifyAssetResult::GOOD;
+	std::exception_ptr hash_error;
+	std::thread hasher ([&]() {
+		try {
+			hash_result = verify_asset (dcp, reel_asset, [&](float hash_progress) {
+				std::unique_lock<std::mutex> lm (mutex);
+				condition.wait (lm, [&]() { return frames_finished || hash_progress <= frames_progress + lead; });
+			});
+		} catch (...) {
+			hash_error = std::current_exception ();
+		}
+	});
+
+	vector<VerificationNote> picture_notes;
+	try {
+		verify_picture_asset (reel_asset, file, picture_notes, [&](float frames) {
+			{
+				std::lock_guard<std::mutex> lm (mutex);
+				frames_progress = frames;
+				condition.notify_all ();
+			}
+			progress (frames);
+		}, threads, map);
+	} catch (...) {
+		finish_frames ();
+		hasher.join ();
+		throw;
+	}
+
+	finish_frames ();
+	hasher.join ();
+
+	if (hash_error) {
+		std::rethrow_exception (hash_error);
+	}
+
+	/* Give the notes in the same order as if we had checked the hash first */
+	add_picture_hash_notes (hash_result, file, notes);
+	for (auto const& i: picture_notes) {
+		if (find(notes.begin(), notes.end(), i) == notes.end()) {
+			notes.push_back (i);
+		}
+	}
+}
+
+
+static void
+verify_main_picture_asset (
+	shared_ptr<const DCP> dcp,
+	shared_ptr<const ReelPictureAsset> reel_asset,
+	function<void (string, optional<boost::filesystem::path>)> stage,
+	function<void (float)> progress,
+	vector<VerificationNote>& notes,
+	VerificationOptions const& options
+	)
+{
+	auto asset = reel_asset->asset();
+	auto const file = *asset->file();
+
+	if (options.single_pass) {
+		stage ("Checking picture asset hash and frame sizes", file);
+		verify_picture_asset_single_pass (dcp, reel_asset, file, progress, notes, options.threads, options.map_picture_assets);
+	} else {
+		stage ("Checking picture asset hash", file);
+		add_picture_hash_notes (verify_asset(dcp, reel_asset, progress), file, notes);
+		stage ("Checking picture frame sizes", asset->file());
+		verify_picture_asset (reel_asset, file, notes, progress, options.threads, options.map_picture_assets);
+	}
 
 	/* Only flat/scope allowed by Bv2.1 */
 	if (
@@ -1261,7 +1520,8 @@ dcp::verify (
 	vector<boost::filesystem::path> directories,
 	function<void (string, optional<boost::filesystem::path>)> stage,
 	function<void (float)> progress,
-	optional<boost::filesystem::path> xsd_dtd_directory
+	optional<boost::filesystem::path> xsd_dtd_directory,
+	VerificationOptions options
 	)
 {
 	if (!xsd_dtd_directory) {
@@ -1281,7 +1541,7 @@ dcp::verify (
 		stage ("Checking DCP", dcp->directory());
 		bool carry_on = true;
 		try {
-			dcp->read (&notes, true);
+			dcp->read (&notes, true, options.threads);
 		} catch (MissingAssetmapError& e) {
 			notes.push_back ({VerificationNote::Type::ERROR, VerificationNote::Code::FAILED_READ, string(e.what())});
 			carry_on = false;
@@ -1303,6 +1563,23 @@ dcp::verify (
 			notes.push_back ({VerificationNote::Type::BV21_ERROR, VerificationNote::Code::INVALID_STANDARD});
 		}
 
+		if (options.hash_threads > 1) {
+			/* Hash all the assets that we will check at once, rather than one by one as we come to them */
+			stage ("Checking asset hashes", dcp->directory());
+			vector<shared_ptr<const Asset>> to_hash;
+			for (auto cpl: dcp->cpls()) {
+				for (auto reel: cpl->reels()) {
+					if (reel->main_picture() && reel->main_picture()->asset_ref().resolved() && !options.single_pass) {
+						to_hash.push_back (reel->main_picture()->asset());
+					}
+					if (reel->main_sound() && reel->main_sound()->asset_ref().resolved()) {
+						to_hash.push_back (reel->main_sound()->asset());
+					}
+				}
+			}
+			hash_assets (to_hash, options.hash_threads, progress);
+		}
+
 		for (auto cpl: dcp->cpls()) {
 			stage ("Checking CPL", cpl->file());
 			validate_xml (cpl->file().get(), *xsd_dtd_directory, notes);
@@ -1423,7 +1700,7 @@ dcp::verify (
 					}
 					/* Check asset */
 					if (reel->main_picture()->asset_ref().resolved()) {
-						verify_main_picture_asset (dcp, reel->main_picture(), stage, progress, notes);
+						verify_main_picture_asset (dcp, reel->main_picture(), stage, progress, notes, options);
 					}
 				}
 
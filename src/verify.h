@@ -458,11 +458,42 @@ private:
 };
 
 
+struct VerificationOptions
+{
+	/** Number of threads to use to read and check picture frames, and to open each DCP's MXFs;
+	 *  each thread holds one frame at a time.
+	 */
+	int threads = 1;
+	/** true to hash each picture asset at the same time as its frames are checked, so that it
+	 *  is only read from storage once rather than twice.
+	 */
+	bool single_pass = false;
+	/** Number of asset files to hash at once before the other checks, or 1 to hash each one as it is checked;
+	 *  see hash_assets().
+	 */
+	int hash_threads = 1;
+	/** true to read picture frames from a memory-mapped copy of each asset when it has a frame index
+	 *  (see MonoPictureAsset::start_read()), rather than with asdcplib.  This is faster, but if an
+	 *  asset's file is truncated or cannot be read the process will be killed by SIGBUS rather than
+	 *  an error being reported.
+	 */
+	bool map_picture_assets = false;
+};
+
+
+/** Verify some DCPs.
+ *  @param stage Called with a description of each stage of the verification as it starts.
+ *  @param progress Called with the progress (from 0 to 1) of long-running stages; always called from the calling thread.
+ *  @param xsd_dtd_directory Directory containing XSD/DTD files, or empty to use the ones installed with libdcp.
+ *  @param options Options to control how the verification is done.
+ *  @return Notes about any problems that were found.
+ */
 std::vector<VerificationNote> verify (
 	std::vector<boost::filesystem::path> directories,
 	boost::function<void (std::string, boost::optional<boost::filesystem::path>)> stage,
 	boost::function<void (float)> progress,
-	boost::optional<boost::filesystem::path> xsd_dtd_directory = boost::optional<boost::filesystem::path>()
+	boost::optional<boost::filesystem::path> xsd_dtd_directory = boost::optional<boost::filesystem::path>(),
+	VerificationOptions options = VerificationOptions()
 	);
 
 std::string note_to_string (dcp::VerificationNote note);
@@ -42,12 +42,12 @@
 #include "raw_convert.h"
 #include "verify.h"
 #include "verify_j2k.h"
+#include <algorithm>
 #include <memory>
 #include <vector>
 
 
 using std::shared_ptr;
-using std::map;
 using std::runtime_error;
 using std::string;
 using std::vector;
@@ -64,6 +64,57 @@ public:
 };
 
 
+enum class Marker
+{
+	UNKNOWN,
+	SOC,
+	SIZ,
+	COD,
+	COC,
+	TLM,
+	QCD,
+	QCC,
+	POC,
+	COM,
+	SOT,
+	SOD,
+	EOC
+};
+
+
+/** Lookup from the second byte of a marker to the marker that it identifies */
+class MarkerTable
+{
+public:
+	MarkerTable ()
+	{
+		std::fill (_markers, _markers + 256, Marker::UNKNOWN);
+		_markers[0x4f] = Marker::SOC;
+		_markers[0x51] = Marker::SIZ;
+		_markers[0x52] = Marker::COD;
+		_markers[0x53] = Marker::COC;
+		_markers[0x55] = Marker::TLM;
+		_markers[0x5c] = Marker::QCD;
+		_markers[0x5d] = Marker::QCC;
+		_markers[0x5f] = Marker::POC;
+		_markers[0x64] = Marker::COM;
+		_markers[0x90] = Marker::SOT;
+		_markers[0x93] = Marker::SOD;
+		_markers[0xd9] = Marker::EOC;
+	}
+
+	Marker operator[] (uint8_t id) const {
+		return _markers[id];
+	}
+
+private:
+	Marker _markers[256];
+};
+
+
+static MarkerTable const marker_table;
+
+
 void
 dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 {
@@ -71,37 +122,13 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 		auto ptr = j2k->data();
 		auto end = ptr + j2k->size();
 
-		map<string, uint8_t> markers = {
-			{ "SOC", 0x4f },
-			{ "SIZ", 0x51 },
-			{ "COD", 0x52 },
-			{ "COC", 0x53 },
-			{ "TLM", 0x55 },
-			{ "QCD", 0x5c },
-			{ "QCC", 0x5d },
-			{ "POC", 0x5f },
-			{ "COM", 0x64 },
-			{ "SOT", 0x90 },
-			{ "SOD", 0x93 },
-			{ "EOC", 0xd9 },
-		};
-
-		auto marker_name_from_id = [&markers](uint8_t b) -> optional<string> {
-			for (auto const& i: markers) {
-				if (i.second == b) {
-					return i.first;
-				}
-			}
-			return {};
-		};
-
-		auto require_marker = [&](string name) {
+		auto require_marker = [&](Marker marker, char const * name) {
 			if (ptr == end || *ptr != 0xff) {
 				throw InvalidCodestream ("missing marker start byte");
 			}
 			++ptr;
-			if (ptr == end || *ptr != markers[name]) {
-				throw InvalidCodestream ("missing_marker " + name);
+			if (ptr == end || marker_table[*ptr] != marker) {
+				throw InvalidCodestream (String::compose("missing_marker %1", name));
 			}
 			++ptr;
 		};
@@ -133,29 +160,29 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 			return d | (c << 8) | (b << 16) | (a << 24);
 		};
 
-		auto require_8 = [&](uint8_t value, string note) {
+		auto require_8 = [&](uint8_t value, char const * note) {
 			auto v = get_8 ();
 			if (v != value) {
 				throw InvalidCodestream (String::compose(note, v));
 			}
 		};
 
-		auto require_16 = [&](uint16_t value, string note) {
+		auto require_16 = [&](uint16_t value, char const * note) {
 			auto v = get_16 ();
 			if (v != value) {
 				throw InvalidCodestream (String::compose(note, v));
 			}
 		};
 
-		auto require_32 = [&](uint32_t value, string note) {
+		auto require_32 = [&](uint32_t value, char const * note) {
 			auto v = get_32 ();
 			if (v != value) {
 				throw InvalidCodestream (String::compose(note, v));
 			}
 		};
 
-		require_marker ("SOC");
-		require_marker ("SIZ");
+		require_marker (Marker::SOC, "SOC");
+		require_marker (Marker::SIZ, "SIZ");
 		auto L_siz = get_16();
 		if (L_siz != 47) {
 			throw InvalidCodestream("unexpected SIZ size " + raw_convert<string>(L_siz));
@@ -189,20 +216,31 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 		auto num_POC_after_main = 0;
 		bool main_header_finished = false;
 		bool tlm = false;
+		/** end of the current tile-part according to its SOT marker, if that is usable */
+		uint8_t const * tile_part_end = nullptr;
 
 		while (ptr < end)
 		{
+			auto const marker_start = ptr;
 			require_8(0xff, "missing marker start byte");
 			auto marker_id = get_8();
-			auto marker_name = marker_name_from_id (marker_id);
-			if (!marker_name) {
+			switch (marker_table[marker_id]) {
+			case Marker::UNKNOWN:
+			{
 				char buffer[16];
 				snprintf (buffer, 16, "%2x", marker_id);
 				throw InvalidCodestream(String::compose("unknown marker %1", buffer));
-			} else if (*marker_name == "SOT") {
+			}
+			case Marker::SOT:
+			{
 				require_16(10, "invalid SOT size %1");
 				get_16(); // tile index
-				get_32(); // tile part length
+				auto const tile_part_length = get_32();
+				/* A length of 0 means that the tile-part goes on to the EOC */
+				tile_part_end = nullptr;
+				if (tile_part_length > 0 && tile_part_length <= static_cast<uint32_t>(end - marker_start)) {
+					tile_part_end = marker_start + tile_part_length;
+				}
 				get_8(); // tile part index
 				auto tile_parts = get_8();
 				if (!fourk && tile_parts != 3) {
@@ -212,13 +250,23 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 					notes.push_back ({ VerificationNote::Type::BV21_ERROR, VerificationNote::Code::INVALID_JPEG2000_TILE_PARTS_FOR_4K, raw_convert<string>(tile_parts) });
 				}
 				main_header_finished = true;
-			} else if (*marker_name == "SOD") {
-				while (ptr < (end - 1) && (ptr[0] != 0xff || ptr[1] < 0x90)) {
-					++ptr;
+				break;
+			}
+			case Marker::SOD:
+				if (tile_part_end && tile_part_end >= ptr && (tile_part_end == end || (tile_part_end < (end - 1) && tile_part_end[0] == 0xff && tile_part_end[1] >= 0x90))) {
+					/* The tile-part length looks right, so use it to jump over the tile data to the next marker */
+					ptr = tile_part_end;
+				} else {
+					while (ptr < (end - 1) && (ptr[0] != 0xff || ptr[1] < 0x90)) {
+						++ptr;
+					}
 				}
-			} else if (*marker_name == "SIZ") {
+				tile_part_end = nullptr;
+				break;
+			case Marker::SIZ:
 				throw InvalidCodestream ("duplicate SIZ marker");
-			} else if (*marker_name == "COD") {
+			case Marker::COD:
+			{
 				num_COD++;
 				get_16(); // length
 				/* XXX: I can't find any evidence for this: must the coding style really always be 1? */
@@ -246,7 +294,10 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 				if (fourk) {
 					require_8(0x88, "invalid precinct size %1");
 				}
-			} else if (*marker_name == "QCD") {
+				break;
+			}
+			case Marker::QCD:
+			{
 				num_QCD++;
 				auto const L_qcd = get_16();
 				auto quantization_style = get_8();
@@ -258,7 +309,9 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 					notes.push_back ({ VerificationNote::Type::BV21_ERROR, VerificationNote::Code::INVALID_JPEG2000_GUARD_BITS_FOR_2K, raw_convert<string>(guard_bits) });
 				}
 				ptr += L_qcd - 3;
-			} else if (*marker_name == "COC") {
+				break;
+			}
+			case Marker::COC:
 				get_16(); // length
 				require_8(0, "invalid COC component number");
 				/* XXX: I can't find any evidence for this: must the coding style really always be 1? */
@@ -273,27 +326,36 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 				require_8(0x88, "invalid precinct size %1");
 				require_8(0x88, "invalid precinct size %1");
 				require_8(0x88, "invalid precinct size %1");
-			} else if (*marker_name == "TLM") {
+				break;
+			case Marker::TLM:
+			{
 				auto const len = get_16();
 				ptr += len - 2;
 				tlm = true;
-			} else if (*marker_name == "QCC" || *marker_name == "COM") {
+				break;
+			}
+			case Marker::QCC:
+			case Marker::COM:
+			{
 				auto const len = get_16();
 				ptr += len - 2;
-			} else if (*marker_name == "POC") {
+				break;
+			}
+			case Marker::POC:
+			{
 				if (main_header_finished) {
 					num_POC_after_main++;
 				} else {
 					num_POC_in_main++;
 				}
 
-				auto require_8_poc = [&](uint16_t value, string note) {
+				auto require_8_poc = [&](uint16_t value, char const * note) {
 					if (get_8() != value) {
 						notes.push_back ({ VerificationNote::Type::BV21_ERROR, VerificationNote::Code::INCORRECT_JPEG2000_POC_MARKER, String::compose(note, value) });
 					}
 				};
 
-				auto require_16_poc = [&](uint16_t value, string note) {
+				auto require_16_poc = [&](uint16_t value, char const * note) {
 					if (get_16() != value) {
 						notes.push_back ({ VerificationNote::Type::BV21_ERROR, VerificationNote::Code::INCORRECT_JPEG2000_POC_MARKER, String::compose(note, value) });
 					}
@@ -312,6 +374,11 @@ dcp::verify_j2k (shared_ptr<const Data> j2k, vector<VerificationNote>& notes)
 				require_8_poc(7, "invalid REpoc %1");
 				require_8_poc(3, "invalid CEpoc %1");
 				require_8_poc(4, "invalid Ppoc %1");
+				break;
+			}
+			case Marker::SOC:
+			case Marker::EOC:
+				break;
 			}
 		}
 
@@ -0,0 +1,139 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "asset_index.h"
+#include "exceptions.h"
+#include "font_asset.h"
+#include "lazy_asset.h"
+#include "ref.h"
+#include <boost/test/unit_test.hpp>
+
+
+using std::make_shared;
+
+
+/** Check that AssetIndex finds assets in the same way that ids_equal() compares IDs */
+BOOST_AUTO_TEST_CASE (asset_index_test)
+{
+	auto a = make_shared<dcp::FontAsset>("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1", "test/data/dummy.ttf");
+	auto b = make_shared<dcp::FontAsset>("1fc1b3f4-21d1-4d7c-8b89-0a0c8c6e6a66", "test/data/dummy.ttf");
+	auto b2 = make_shared<dcp::FontAsset>("1FC1B3F4-21D1-4D7C-8B89-0A0C8C6E6A66", "test/data/dummy.ttf");
+
+	dcp::AssetIndex index ({ a, b });
+	index.add (b2);
+
+	BOOST_CHECK (index.find("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1") == a);
+	BOOST_CHECK (index.find("4D4FA8E6-F4B6-4B1E-B77E-15A0B1B0F7B1") == a);
+	BOOST_CHECK (index.find(" 4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1\n") == a);
+	/* The first asset with an ID wins */
+	BOOST_CHECK (index.find("1fc1b3f4-21d1-4d7c-8b89-0a0c8c6e6a66") == b);
+	BOOST_CHECK (!index.find("8a34b1b4-8b35-4d8a-9f39-8cf84e2fd8c8"));
+	BOOST_CHECK_EQUAL (index.assets().size(), 3U);
+
+	dcp::Ref ref ("4D4FA8E6-f4b6-4b1e-b77e-15a0b1b0f7b1");
+	ref.resolve (index);
+	BOOST_CHECK (ref.resolved());
+	BOOST_CHECK (ref.asset() == a);
+
+	dcp::Ref missing ("8a34b1b4-8b35-4d8a-9f39-8cf84e2fd8c8");
+	missing.resolve (index);
+	BOOST_CHECK (!missing.resolved());
+}
+
+
+/** Check that a Ref which is resolved to a LazyAsset only makes the asset when it is asked for */
+BOOST_AUTO_TEST_CASE (asset_index_lazy_test)
+{
+	int loads = 0;
+	auto lazy = make_shared<dcp::LazyAsset>("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1", [&loads]() {
+		++loads;
+		return make_shared<dcp::FontAsset>("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1", "test/data/dummy.ttf");
+	});
+
+	dcp::AssetIndex index;
+	index.add (lazy);
+	BOOST_CHECK (!index.find("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1"));
+	BOOST_CHECK (index.find_lazy("4D4FA8E6-F4B6-4B1E-B77E-15A0B1B0F7B1") == lazy);
+	BOOST_CHECK (index.assets().empty());
+
+	dcp::Ref ref ("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1");
+	ref.resolve (index);
+	BOOST_CHECK (ref.resolved());
+	BOOST_CHECK (!ref.loaded());
+	BOOST_CHECK_EQUAL (loads, 0);
+
+	auto asset = ref.asset ();
+	BOOST_CHECK (ref.loaded());
+	BOOST_CHECK_EQUAL (ref->id(), "4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1");
+	BOOST_CHECK (ref.asset() == asset);
+	BOOST_CHECK_EQUAL (loads, 1);
+}
+
+
+/** Check that AssetIndex finds font assets by the leaf names of their files, as Interop subtitles refer to them */
+BOOST_AUTO_TEST_CASE (asset_index_font_test)
+{
+	auto a = make_shared<dcp::FontAsset>("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1", "test/data/dummy.ttf");
+	auto b = make_shared<dcp::FontAsset>("1fc1b3f4-21d1-4d7c-8b89-0a0c8c6e6a66", "test/data/dummy.ttf");
+
+	dcp::AssetIndex index ({ a, b });
+
+	/* The first font with a given leaf name wins */
+	BOOST_CHECK (index.find_font("dummy.ttf") == a);
+	BOOST_CHECK (!index.find_font("test/data/dummy.ttf"));
+	BOOST_CHECK (!index.find_font("missing.ttf"));
+}
+
+
+/** Check that a LazyAsset which makes an asset with a different ID does not give it out */
+BOOST_AUTO_TEST_CASE (asset_index_lazy_mismatched_id_test)
+{
+	auto lazy = make_shared<dcp::LazyAsset>("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1", []() {
+		return make_shared<dcp::FontAsset>("1fc1b3f4-21d1-4d7c-8b89-0a0c8c6e6a66", "test/data/dummy.ttf");
+	});
+
+	dcp::AssetIndex index;
+	index.add (lazy);
+
+	dcp::Ref ref ("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1");
+	ref.resolve (index);
+	BOOST_CHECK_THROW (ref.asset(), dcp::UnresolvedRefError);
+	BOOST_CHECK (!ref.loaded());
+
+	/* IDs which differ only in case still match */
+	auto upper = make_shared<dcp::LazyAsset>("4D4FA8E6-F4B6-4B1E-B77E-15A0B1B0F7B1", []() {
+		return make_shared<dcp::FontAsset>("4d4fa8e6-f4b6-4b1e-b77e-15a0b1b0f7b1", "test/data/dummy.ttf");
+	});
+	BOOST_CHECK (upper->get());
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "asset_reader_pool.h"
+#include "mono_picture_asset.h"
+#include "mono_picture_asset_reader.h"
+#include "mono_picture_frame.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+
+using std::shared_ptr;
+using std::thread;
+using std::vector;
+
+
+/** Read every frame of an asset many times from several threads at once through an AssetReaderPool
+ *  and check that we always get the right data, without opening more readers than we asked for.
+ */
+BOOST_AUTO_TEST_CASE (asset_reader_pool_test)
+{
+	boost::filesystem::path const file = "build/test/asset_reader_pool_test.mxf";
+	int const frames = 8;
+
+	auto mp = random_picture_asset (file, frames);
+
+	vector<shared_ptr<const dcp::MonoPictureFrame>> reference;
+	auto reader = mp->start_read ();
+	for (int i = 0; i < frames; ++i) {
+		reference.push_back (reader->get_frame(i));
+	}
+
+	int const threads = 4;
+	int const max_readers = 2;
+	auto pool = dcp::make_asset_reader_pool (mp, max_readers);
+
+	std::atomic<int> errors (0);
+	vector<thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.push_back (thread([pool, &reference, &errors, t]() {
+			for (int i = 0; i < 64; ++i) {
+				int const n = (i * 3 + t) % frames;
+				auto frame = pool->get_frame (n);
+				if (frame->size() != reference[n]->size() || !std::equal(frame->data(), frame->data() + frame->size(), reference[n]->data())) {
+					++errors;
+				}
+			}
+		}));
+	}
+
+	for (auto& i: workers) {
+		i.join ();
+	}
+
+	BOOST_CHECK_EQUAL (errors, 0);
+	BOOST_CHECK (pool->readers_opened() >= 1);
+	BOOST_CHECK (pool->readers_opened() <= max_readers);
+
+	/* A reader which is taken from the pool goes back when we have finished with it */
+	int const opened = pool->readers_opened ();
+	{
+		auto r = pool->reader ();
+		BOOST_CHECK_EQUAL (r->get_frame(1)->size(), reference[1]->size());
+	}
+	pool->reader ();
+	BOOST_CHECK_EQUAL (pool->readers_opened(), opened);
+}
@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "exceptions.h"
+#include "frame_prefetcher.h"
+#include "mono_picture_asset.h"
+#include "mono_picture_asset_reader.h"
+#include "mono_picture_frame.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <atomic>
+
+
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+
+
+/** Check that a reader which is prefetching gives the same frames as one which is not,
+ *  whether frames are asked for in order, skipped, repeated or asked for out of order.
+ */
+BOOST_AUTO_TEST_CASE (asset_reader_prefetch_test)
+{
+	boost::filesystem::path const file = "build/test/asset_reader_prefetch_test.mxf";
+	int const frames = 12;
+
+	auto mp = random_picture_asset (file, frames);
+
+	auto reference = mp->start_read ();
+
+	for (auto depth: { 1, 4, 16 }) {
+		auto reader = mp->start_read ();
+		reader->set_prefetch (depth);
+		for (auto i: vector<int>{ 0, 1, 2, 3, 5, 5, 6, 11, 2, 3, 4, 0, 7, 8, 9, 10, 11 }) {
+			auto a = reader->get_frame (i);
+			auto b = reference->get_frame (i);
+			BOOST_REQUIRE_EQUAL (a->size(), b->size());
+			BOOST_CHECK (std::equal(a->data(), a->data() + a->size(), b->data()));
+		}
+
+		/* Frames past the end can't be read, with or without prefetching */
+		BOOST_CHECK_THROW (reader->get_frame(frames), dcp::ReadError);
+
+		reader->set_prefetch (0);
+		BOOST_CHECK_EQUAL (reader->get_frame(3)->size(), reference->get_frame(3)->size());
+	}
+}
+
+
+/** Check that a prefetcher does not read past the end of an asset unless it is asked to */
+BOOST_AUTO_TEST_CASE (frame_prefetcher_end_test)
+{
+	int const frames = 5;
+	std::atomic<int> last_read (-1);
+	std::atomic<int> reads_past_end (0);
+
+	{
+		dcp::FramePrefetcher<int> prefetcher ([&](int n) -> shared_ptr<const int> {
+			last_read = std::max (last_read.load(), n);
+			if (n >= frames) {
+				++reads_past_end;
+				throw dcp::ReadError ("past the end");
+			}
+			return make_shared<int>(n);
+		}, 4, frames);
+
+		for (int i = 0; i < frames; ++i) {
+			BOOST_CHECK_EQUAL (*prefetcher.get(i), i);
+		}
+	}
+
+	BOOST_CHECK_EQUAL (last_read, frames - 1);
+	BOOST_CHECK_EQUAL (reads_past_end, 0);
+
+	dcp::FramePrefetcher<int> prefetcher ([&](int n) -> shared_ptr<const int> {
+		if (n >= frames) {
+			++reads_past_end;
+			throw dcp::ReadError ("past the end");
+		}
+		return make_shared<int>(n);
+	}, 4, frames);
+
+	BOOST_CHECK_EQUAL (*prefetcher.get(frames - 1), frames - 1);
+	BOOST_CHECK_THROW (prefetcher.get(frames), dcp::ReadError);
+	BOOST_CHECK_EQUAL (reads_past_end, 1);
+}
@@ -36,9 +36,12 @@
 #include "modified_gamma_transfer_function.h"
 #include <boost/test/unit_test.hpp>
 #include <cmath>
+#include <thread>
+#include <vector>
 
 using std::pow;
 using std::shared_ptr;
+using std::vector;
 using namespace dcp;
 
 static void
@@ -154,3 +157,28 @@ BOOST_AUTO_TEST_CASE (colour_conversion_bradford_test)
 	BOOST_CHECK_CLOSE (b(2, 1), 0.0119945, 0.1);
 	BOOST_CHECK_CLOSE (b(2, 2), 0.7785377, 0.1);
 }
+
+
+/** Check that many threads asking for the same LUT at once all get the same one */
+BOOST_AUTO_TEST_CASE (transfer_function_lut_threads_test)
+{
+	auto tf = std::make_shared<GammaTransferFunction>(2.2);
+
+	vector<double const *> luts (16);
+	vector<std::thread> threads;
+	for (size_t i = 0; i < luts.size(); ++i) {
+		threads.push_back (std::thread([tf, i, &luts]() { luts[i] = tf->lut (16, true); }));
+	}
+	for (auto& i: threads) {
+		i.join ();
+	}
+
+	for (auto i: luts) {
+		BOOST_CHECK (i == luts[0]);
+	}
+
+	check_gamma (tf, 16, true, 1 / 2.2);
+
+	/* The standard conversions should share their transfer functions */
+	BOOST_CHECK (ColourConversion::srgb_to_xyz().out() == ColourConversion::rec709_to_xyz().out());
+}
@@ -0,0 +1,242 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "cpl.h"
+#include "dcp.h"
+#include "dcp_cache.h"
+#include "exceptions.h"
+#include "pkl.h"
+#include "reel.h"
+#include "reel_file_asset.h"
+#include "reel_picture_asset.h"
+#include "search.h"
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+
+
+using std::string;
+using std::vector;
+
+
+static void
+copy_dcp (boost::filesystem::path from, boost::filesystem::path to)
+{
+	boost::filesystem::remove_all (to);
+	boost::filesystem::create_directories (to);
+	for (auto i: boost::filesystem::directory_iterator(from)) {
+		boost::filesystem::copy_file (i.path(), to / i.path().filename());
+	}
+}
+
+
+/** Read a DCP twice through a cache and check that the second read uses the snapshot */
+BOOST_AUTO_TEST_CASE (dcp_cache_test1)
+{
+	boost::filesystem::path const dir = "build/test/dcp_cache_test1";
+	copy_dcp ("test/ref/DCP/dcp_test1", dir / "dcp");
+	boost::filesystem::remove_all (dir / "cache");
+
+	dcp::DCPCache cache (dir / "cache");
+
+	auto first = cache.read (dir / "dcp");
+	BOOST_CHECK_EQUAL (cache.hits(), 0);
+	BOOST_CHECK_EQUAL (cache.misses(), 1);
+
+	vector<dcp::VerificationNote> notes;
+	auto second = cache.read (dir / "dcp", &notes);
+	BOOST_CHECK_EQUAL (cache.hits(), 1);
+	BOOST_CHECK_EQUAL (cache.misses(), 1);
+	BOOST_CHECK (notes.empty());
+	/* The DCP read the first time should be used again */
+	BOOST_CHECK (second == first);
+
+	BOOST_REQUIRE_EQUAL (first->cpls().size(), 1U);
+	for (auto i: first->cpls()[0]->reel_file_assets()) {
+		/* A miss reads the DCP in full */
+		BOOST_CHECK (i->asset_ref().loaded());
+	}
+
+	/* A different cache using the same directory should read the snapshot from disk */
+	dcp::DCPCache other (dir / "cache");
+	auto third = other.read (dir / "dcp", &notes);
+	BOOST_CHECK_EQUAL (other.hits(), 1);
+	BOOST_CHECK_EQUAL (other.misses(), 0);
+	BOOST_CHECK (notes.empty());
+
+	BOOST_REQUIRE_EQUAL (third->cpls().size(), 1U);
+	BOOST_CHECK_EQUAL (first->cpls()[0]->id(), third->cpls()[0]->id());
+	BOOST_CHECK_EQUAL (first->standard().get(), third->standard().get());
+
+	/* Everything should refer to the DCP, not to the snapshot */
+	auto const canonical = boost::filesystem::canonical(dir / "dcp");
+	BOOST_CHECK (third->cpls()[0]->file()->parent_path() == canonical);
+	BOOST_REQUIRE_EQUAL (third->pkls().size(), 1U);
+	BOOST_CHECK (third->pkls()[0]->file()->parent_path() == canonical);
+	BOOST_CHECK (third->asset_map_path()->parent_path() == canonical);
+
+	auto first_assets = first->cpls()[0]->reel_file_assets();
+	auto third_assets = third->cpls()[0]->reel_file_assets();
+	BOOST_REQUIRE_EQUAL (first_assets.size(), third_assets.size());
+	for (size_t i = 0; i < third_assets.size(); ++i) {
+		/* The asset files were checked when the snapshot was taken, so they are not opened again until needed */
+		BOOST_CHECK (!third_assets[i]->asset_ref().loaded());
+		BOOST_CHECK_EQUAL (third_assets[i]->asset_ref()->id(), first_assets[i]->asset_ref()->id());
+		BOOST_CHECK (third_assets[i]->asset_ref()->file() == first_assets[i]->asset_ref()->file());
+	}
+
+	/* Now the snapshot has been read from disk it is used without reading anything */
+	BOOST_CHECK (other.read(dir / "dcp") == third);
+	BOOST_CHECK_EQUAL (other.hits(), 2);
+}
+
+
+/** Check that changing a DCP's files means that its snapshot is not used */
+BOOST_AUTO_TEST_CASE (dcp_cache_test2)
+{
+	boost::filesystem::path const dir = "build/test/dcp_cache_test2";
+	copy_dcp ("test/ref/DCP/dcp_test1", dir / "dcp");
+	boost::filesystem::remove_all (dir / "cache");
+
+	dcp::DCPCache cache (dir / "cache");
+	cache.read (dir / "dcp");
+	cache.read (dir / "dcp");
+	BOOST_CHECK_EQUAL (cache.hits(), 1);
+	BOOST_CHECK_EQUAL (cache.misses(), 1);
+
+	{
+		std::ofstream volindex ((dir / "dcp" / "VOLINDEX.xml").string(), std::ios::app);
+		volindex << "\n";
+	}
+
+	cache.read (dir / "dcp");
+	BOOST_CHECK_EQUAL (cache.hits(), 1);
+	BOOST_CHECK_EQUAL (cache.misses(), 2);
+
+	cache.read (dir / "dcp");
+	BOOST_CHECK_EQUAL (cache.hits(), 2);
+	BOOST_CHECK_EQUAL (cache.misses(), 2);
+
+	/* A new file is a change too */
+	boost::filesystem::copy_file (dir / "dcp" / "VOLINDEX.xml", dir / "dcp" / "extra.xml");
+	cache.read (dir / "dcp");
+	BOOST_CHECK_EQUAL (cache.hits(), 2);
+	BOOST_CHECK_EQUAL (cache.misses(), 3);
+}
+
+
+BOOST_AUTO_TEST_CASE (dcp_cache_search_test)
+{
+	boost::filesystem::path const dir = "build/test/dcp_cache_search_test";
+	copy_dcp ("test/ref/DCP/dcp_test1", dir / "dcp");
+	boost::filesystem::remove_all (dir / "cache");
+
+	dcp::DCPCache cache (dir / "cache");
+	auto first = dcp::find_and_resolve_cpls ({dir / "dcp"}, false, &cache);
+	auto second = dcp::find_and_resolve_cpls ({dir / "dcp"}, false, &cache);
+	BOOST_CHECK_EQUAL (cache.hits(), 1);
+	BOOST_CHECK_EQUAL (cache.misses(), 1);
+
+	BOOST_REQUIRE_EQUAL (first.size(), 1U);
+	BOOST_REQUIRE_EQUAL (second.size(), 1U);
+	BOOST_CHECK_EQUAL (first[0]->id(), second[0]->id());
+	for (auto i: second[0]->reel_file_assets()) {
+		BOOST_CHECK (i->asset_ref().resolved());
+	}
+
+	dcp::DCPCache other (dir / "cache");
+	auto third = dcp::find_and_resolve_cpls ({dir / "dcp"}, false, &other);
+	BOOST_CHECK_EQUAL (other.hits(), 1);
+	BOOST_REQUIRE_EQUAL (third.size(), 1U);
+	for (auto i: third[0]->reel_file_assets()) {
+		BOOST_CHECK (i->asset_ref().resolved());
+		BOOST_CHECK (!i->asset_ref().loaded());
+	}
+}
+
+
+/** Check that a DCP with a broken MXF gives the same error whether or not a cache is used */
+BOOST_AUTO_TEST_CASE (dcp_cache_broken_mxf_test)
+{
+	boost::filesystem::path const dir = "build/test/dcp_cache_broken_mxf_test";
+	copy_dcp ("test/ref/DCP/dcp_test1", dir / "dcp");
+	boost::filesystem::remove_all (dir / "cache");
+
+	{
+		boost::filesystem::remove (dir / "dcp" / "video.mxf");
+		std::ofstream video ((dir / "dcp" / "video.mxf").string());
+		video << "This is not an MXF\n";
+	}
+
+	BOOST_CHECK_THROW (dcp::find_and_resolve_cpls({dir / "dcp"}, false), dcp::ReadError);
+
+	dcp::DCPCache cache (dir / "cache");
+	for (int i = 0; i < 2; ++i) {
+		BOOST_CHECK_THROW (dcp::find_and_resolve_cpls({dir / "dcp"}, false, &cache), dcp::ReadError);
+	}
+
+	/* There is no snapshot of a DCP which could not be read */
+	BOOST_CHECK_EQUAL (cache.hits(), 0);
+	BOOST_CHECK_EQUAL (cache.misses(), 2);
+}
+
+
+/** Check that notes from reading a DCP are given again when its snapshot is used */
+BOOST_AUTO_TEST_CASE (dcp_cache_notes_test)
+{
+	boost::filesystem::path const dir = "build/test/dcp_cache_notes_test";
+	copy_dcp ("test/ref/DCP/dcp_test1", dir / "dcp");
+	boost::filesystem::remove_all (dir / "cache");
+	boost::filesystem::remove (dir / "dcp" / "audio.mxf");
+
+	auto check = [dir](dcp::DCPCache& cache) {
+		vector<dcp::VerificationNote> notes;
+		cache.read (dir / "dcp", &notes);
+		BOOST_REQUIRE_EQUAL (notes.size(), 1U);
+		BOOST_CHECK (notes[0].code() == dcp::VerificationNote::Code::MISSING_ASSET);
+		BOOST_REQUIRE (notes[0].file());
+		BOOST_CHECK (*notes[0].file() == boost::filesystem::canonical(dir / "dcp") / "audio.mxf");
+	};
+
+	dcp::DCPCache cache (dir / "cache");
+	check (cache);
+	check (cache);
+	BOOST_CHECK_EQUAL (cache.hits(), 1);
+	BOOST_CHECK_EQUAL (cache.misses(), 1);
+
+	dcp::DCPCache other (dir / "cache");
+	check (other);
+	BOOST_CHECK_EQUAL (other.hits(), 1);
+	BOOST_CHECK_EQUAL (other.misses(), 0);
+}
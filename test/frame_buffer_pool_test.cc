@@ -0,0 +1,210 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "frame_buffer_pool.h"
+#include "mono_picture_asset.h"
+#include "mono_picture_asset_reader.h"
+#include "mono_picture_frame.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstring>
+
+
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+
+
+/** A buffer which just remembers its capacity and counts how many of its kind there have been */
+struct TestBuffer
+{
+	explicit TestBuffer (int capacity_)
+		: capacity (capacity_)
+	{
+		++made;
+	}
+
+	~TestBuffer ()
+	{
+		++destroyed;
+	}
+
+	int capacity;
+
+	static int made;
+	static int destroyed;
+};
+
+
+int TestBuffer::made = 0;
+int TestBuffer::destroyed = 0;
+
+
+void
+set_frame_buffer_capacity (TestBuffer& buffer, int capacity)
+{
+	buffer.capacity = std::max (buffer.capacity, capacity);
+}
+
+
+/** A reader whose frames are all the same size */
+class TestReader
+{
+public:
+	explicit TestReader (int frame_size)
+		: _frame_size (frame_size)
+	{}
+
+	ASDCP::Result_t ReadFrame (int, TestBuffer& buffer, ASDCP::AESDecContext*, ASDCP::HMACContext*)
+	{
+		++reads;
+		return buffer.capacity >= _frame_size ? Kumu::RESULT_OK : Kumu::RESULT_SMALLBUF;
+	}
+
+	int reads = 0;
+
+private:
+	int _frame_size;
+};
+
+
+static dcp::DecryptionContext const no_key (boost::none, dcp::Standard::SMPTE);
+
+
+/** Check that a buffer is used again once the frame that was using it has gone */
+BOOST_AUTO_TEST_CASE (frame_buffer_pool_reuse_test)
+{
+	TestBuffer::made = TestBuffer::destroyed = 0;
+
+	auto pool = make_shared<dcp::FrameBufferPool<TestBuffer>>(1024);
+	TestReader reader (1000);
+
+	shared_ptr<TestBuffer> a;
+	BOOST_REQUIRE (ASDCP_SUCCESS(pool->read(&reader, 0, no_key, false, a)));
+	auto first = a.get();
+	a.reset ();
+
+	shared_ptr<TestBuffer> b;
+	BOOST_REQUIRE (ASDCP_SUCCESS(pool->read(&reader, 1, no_key, false, b)));
+	BOOST_CHECK (b.get() == first);
+	BOOST_CHECK_EQUAL (TestBuffer::made, 1);
+	BOOST_CHECK_EQUAL (TestBuffer::destroyed, 0);
+}
+
+
+/** Check that buffers grow to fit a big frame, and that later buffers are made at the new size */
+BOOST_AUTO_TEST_CASE (frame_buffer_pool_growth_test)
+{
+	TestBuffer::made = TestBuffer::destroyed = 0;
+
+	auto pool = make_shared<dcp::FrameBufferPool<TestBuffer>>(1024);
+	TestReader reader (5000);
+
+	shared_ptr<TestBuffer> a;
+	BOOST_REQUIRE (ASDCP_SUCCESS(pool->read(&reader, 0, no_key, false, a)));
+	/* 1024, 2048, 4096 and then 8192, which fits */
+	BOOST_CHECK_EQUAL (reader.reads, 4);
+	BOOST_CHECK_EQUAL (a->capacity, 8192);
+	BOOST_CHECK_EQUAL (pool->capacity(), 8192);
+
+	/* We are still holding a, so this needs a new buffer, which should be big enough straight away */
+	shared_ptr<TestBuffer> b;
+	BOOST_REQUIRE (ASDCP_SUCCESS(pool->read(&reader, 1, no_key, false, b)));
+	BOOST_CHECK_EQUAL (reader.reads, 5);
+	BOOST_CHECK_EQUAL (b->capacity, 8192);
+	BOOST_CHECK_EQUAL (TestBuffer::made, 2);
+}
+
+
+/** Check that a buffer stops growing at the pool's limit, and that the failure does not change the pool's capacity */
+BOOST_AUTO_TEST_CASE (frame_buffer_pool_max_capacity_test)
+{
+	auto pool = make_shared<dcp::FrameBufferPool<TestBuffer>>(1024);
+	TestReader reader (1024 * Kumu::Megabyte);
+
+	shared_ptr<TestBuffer> a;
+	BOOST_CHECK (pool->read(&reader, 0, no_key, false, a) == Kumu::RESULT_SMALLBUF);
+	BOOST_CHECK_EQUAL (a->capacity, static_cast<int>(256 * Kumu::Megabyte));
+	BOOST_CHECK_EQUAL (pool->capacity(), 1024);
+}
+
+
+/** Check that the pool keeps no more than 4 spare buffers, and that buffers can outlive the pool */
+BOOST_AUTO_TEST_CASE (frame_buffer_pool_free_test)
+{
+	TestBuffer::made = TestBuffer::destroyed = 0;
+
+	auto pool = make_shared<dcp::FrameBufferPool<TestBuffer>>(1024);
+	TestReader reader (1000);
+
+	vector<shared_ptr<TestBuffer>> buffers (6);
+	for (auto& i: buffers) {
+		BOOST_REQUIRE (ASDCP_SUCCESS(pool->read(&reader, 0, no_key, false, i)));
+	}
+	BOOST_CHECK_EQUAL (TestBuffer::made, 6);
+
+	buffers.clear ();
+	BOOST_CHECK_EQUAL (TestBuffer::destroyed, 2);
+
+	shared_ptr<TestBuffer> a;
+	BOOST_REQUIRE (ASDCP_SUCCESS(pool->read(&reader, 0, no_key, false, a)));
+	BOOST_CHECK_EQUAL (TestBuffer::made, 6);
+
+	/* The 3 spare buffers go with the pool, but a stays until we have finished with it */
+	pool.reset ();
+	BOOST_CHECK_EQUAL (TestBuffer::destroyed, 5);
+	BOOST_CHECK_EQUAL (a->capacity, 1024);
+	a.reset ();
+	BOOST_CHECK_EQUAL (TestBuffer::destroyed, 6);
+}
+
+
+/** Check that a reader re-uses its buffers, and that frames are still good after their reader has gone */
+BOOST_AUTO_TEST_CASE (frame_buffer_pool_reader_test)
+{
+	dcp::MonoPictureAsset asset ("test/ref/DCP/dcp_test1/video.mxf");
+
+	auto reader = asset.start_read ();
+	auto first = reader->get_frame (0);
+	auto const first_data = first->data ();
+	first.reset ();
+	auto frame = reader->get_frame (1);
+	BOOST_CHECK (frame->data() == first_data);
+
+	reader.reset ();
+
+	auto check = asset.start_read()->get_frame(1);
+	BOOST_REQUIRE_EQUAL (frame->size(), check->size());
+	BOOST_CHECK_EQUAL (memcmp(frame->data(), check->data(), frame->size()), 0);
+}
@@ -0,0 +1,123 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "frame_index.h"
+#include "mono_picture_asset.h"
+#include "mono_picture_asset_writer.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+
+
+using std::make_shared;
+using std::vector;
+
+
+/** Write an asset with a frame index, and check that the index can be loaded and agrees with what was written */
+BOOST_AUTO_TEST_CASE (frame_index_test)
+{
+	boost::filesystem::path const file = "build/test/frame_index_test.mxf";
+	boost::filesystem::remove (dcp::FrameIndex::sidecar(file));
+
+	vector<dcp::FrameInfo> infos;
+	auto mp = random_picture_asset (file, 8, true, &infos);
+
+	/* The sizes of the codestreams that we wrote */
+	auto reader = mp->start_read ();
+	vector<int> sizes;
+	for (int i = 0; i < 8; ++i) {
+		sizes.push_back (reader->get_frame(i)->size());
+	}
+
+	auto index = mp->frame_index ();
+	BOOST_REQUIRE (index);
+	BOOST_REQUIRE_EQUAL (index->size(), 8);
+	for (int i = 0; i < 8; ++i) {
+		BOOST_CHECK_EQUAL ((*index)[i].offset, infos[i].offset);
+		BOOST_CHECK_EQUAL ((*index)[i].size, infos[i].size);
+		BOOST_CHECK_EQUAL ((*index)[i].essence_size, sizes[i]);
+	}
+	BOOST_CHECK_EQUAL (index->min_essence_size(), *std::min_element(sizes.begin(), sizes.end()));
+	BOOST_CHECK_EQUAL (index->max_essence_size(), *std::max_element(sizes.begin(), sizes.end()));
+
+	/* Once the MXF changes the index should no longer be used */
+	auto f = fopen (file.string().c_str(), "ab");
+	BOOST_REQUIRE (f);
+	fputc (42, f);
+	fclose (f);
+	BOOST_CHECK (!mp->frame_index());
+}
+
+
+/** Check that no index is written if some frames were faked, as we cannot know their codestream sizes */
+BOOST_AUTO_TEST_CASE (frame_index_fake_write_test)
+{
+	boost::filesystem::path const file = "build/test/frame_index_fake_write_test.mxf";
+
+	unsigned int seed = 42;
+	auto frame = random_frame (&seed);
+
+	auto mp = make_shared<dcp::MonoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+	auto writer = mp->start_write (file, false);
+	writer->set_write_frame_index (true);
+	writer->write (frame);
+	auto info = writer->write (frame);
+	writer->finalize ();
+	BOOST_REQUIRE (mp->frame_index());
+
+	auto mp2 = make_shared<dcp::MonoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+	/* Re-write the same file as if we were recovering from a crash after the first frame */
+	writer = mp2->start_write (file, true);
+	writer->set_write_frame_index (true);
+	writer->write (frame);
+	writer->fake_write (info.size);
+	writer->finalize ();
+	BOOST_CHECK (!mp2->frame_index());
+	BOOST_CHECK (!boost::filesystem::exists(dcp::FrameIndex::sidecar(file)));
+}
+
+
+/** Check that writing an asset without an index removes any index of an earlier version of it */
+BOOST_AUTO_TEST_CASE (frame_index_stale_test)
+{
+	boost::filesystem::path const file = "build/test/frame_index_stale_test.mxf";
+
+	random_picture_asset (file, 1, true);
+	BOOST_REQUIRE (boost::filesystem::exists(dcp::FrameIndex::sidecar(file)));
+
+	auto mp = random_picture_asset (file, 2);
+	BOOST_CHECK (!boost::filesystem::exists(dcp::FrameIndex::sidecar(file)));
+	BOOST_CHECK (!mp->frame_index());
+}
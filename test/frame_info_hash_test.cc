@@ -33,8 +33,8 @@
 
 #include "mono_picture_asset.h"
 #include "mono_picture_asset_writer.h"
-#include "j2k_transcode.h"
-#include "openjpeg_image.h"
+#include "test.h"
+#include "util.h"
 #include <boost/test/unit_test.hpp>
 
 using std::string;
@@ -44,14 +44,7 @@ using std::make_shared;
 static void
 check (unsigned int* seed, shared_ptr<dcp::PictureAssetWriter> writer, string hash)
 {
-	shared_ptr<dcp::OpenJPEGImage> xyz (new dcp::OpenJPEGImage (dcp::Size (1998, 1080)));
-	for (int c = 0; c < 3; ++c) {
-		for (int p = 0; p < (1998 * 1080); ++p) {
-			xyz->data(c)[p] = rand_r (seed) & 0xfff;
-		}
-	}
-
-	dcp::ArrayData data = dcp::compress_j2k (xyz, 100000000, 24, false, false);
+	auto data = random_frame (seed);
 
 	dcp::FrameInfo info = writer->write (data.data(), data.size());
 	BOOST_CHECK_EQUAL (info.hash, hash);
@@ -70,3 +63,26 @@ BOOST_AUTO_TEST_CASE (frame_info_hash_test)
 	check (&seed, writer, "ecd77b3fbf459591f24119d4118783fb");
 	check (&seed, writer, "9f10303495b58ccb715c893d40127e22");
 }
+
+
+/** Check that a hash calculated when the writer is finalized is the hash of the file */
+BOOST_AUTO_TEST_CASE (hash_on_finalize_test)
+{
+	auto mp = make_shared<dcp::MonoPictureAsset>(dcp::Fraction (24, 1), dcp::Standard::SMPTE);
+	auto writer = mp->start_write ("build/test/hash_on_finalize_test.mxf", false);
+	writer->set_hash_on_finalize (true);
+
+	unsigned int seed = 42;
+	check (&seed, writer, "9da3d1d93a80683e65d996edae4101ed");
+	writer->finalize ();
+
+	auto const file_hash = dcp::make_digest ("build/test/hash_on_finalize_test.mxf", {});
+
+	/* Change the file; the asset should not notice, as it should already know its hash */
+	auto f = fopen ("build/test/hash_on_finalize_test.mxf", "ab");
+	BOOST_REQUIRE (f);
+	fputc (42, f);
+	fclose (f);
+
+	BOOST_CHECK_EQUAL (mp->hash(), file_hash);
+}
@@ -0,0 +1,137 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "array_data.h"
+#include "exceptions.h"
+#include "j2k_transcode.h"
+#include "openjpeg_image.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+
+
+using std::shared_ptr;
+using std::vector;
+
+
+/* J2KDecoder is not available with OpenJPEG 1 */
+#ifndef LIBDCP_OPENJPEG1
+
+
+static void
+check_same (shared_ptr<dcp::OpenJPEGImage> a, shared_ptr<dcp::OpenJPEGImage> b)
+{
+	BOOST_REQUIRE (a->size() == b->size());
+	auto const pixels = a->size().width * a->size().height;
+	for (int c = 0; c < 3; ++c) {
+		BOOST_CHECK (std::equal(a->data(c), a->data(c) + pixels, b->data(c)));
+	}
+}
+
+
+/** Check that a J2KDecoder, re-used for several frames and with and without threads,
+ *  gives the same images as decompress_j2k.
+ */
+BOOST_AUTO_TEST_CASE (j2k_decoder_test)
+{
+	unsigned int seed = 42;
+	vector<dcp::ArrayData> frames;
+	for (int i = 0; i < 3; ++i) {
+		frames.push_back (random_frame(&seed));
+	}
+
+	for (auto threads: { 1, 4 }) {
+		for (auto reduce: { 0, 1 }) {
+			dcp::J2KDecoder decoder (reduce, threads);
+			BOOST_CHECK_EQUAL (decoder.threads(), threads);
+			BOOST_CHECK_EQUAL (decoder.reduce(), reduce);
+			for (auto const& frame: frames) {
+				check_same (decoder.decode(frame), dcp::decompress_j2k(frame, reduce));
+			}
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE (j2k_decoder_error_test)
+{
+	dcp::ArrayData bad (1024);
+	memset (bad.data(), 0, bad.size());
+	dcp::J2KDecoder decoder (0, 2);
+	BOOST_CHECK_THROW (decoder.decode(bad), dcp::ReadError);
+}
+
+
+/** Check that decoding an area of a frame gives the same pixels as that area of the whole frame */
+BOOST_AUTO_TEST_CASE (j2k_decoder_area_test)
+{
+	unsigned int seed = 42;
+	auto frame = random_frame (&seed);
+	auto full = dcp::decompress_j2k (frame, 0);
+
+	dcp::J2KDecoder decoder;
+	decoder.set_area (300, 200, dcp::Size(512, 256));
+	auto area = decoder.decode (frame);
+	BOOST_REQUIRE (area->size() == dcp::Size(512, 256));
+
+	for (int c = 0; c < 3; ++c) {
+		for (int y = 0; y < 256; ++y) {
+			auto const full_row = full->data(c) + (y + 200) * full->size().width + 300;
+			BOOST_CHECK (std::equal(full_row, full_row + 512, area->data(c) + y * 512));
+		}
+	}
+
+	decoder.set_reduce (1);
+	BOOST_CHECK (decoder.decode(frame)->size() == dcp::Size(256, 128));
+
+	decoder.unset_area ();
+	decoder.set_reduce (0);
+	check_same (decoder.decode(frame), full);
+}
+
+
+/** Our frames have only one quality layer, so limiting decode to one layer should make no difference */
+BOOST_AUTO_TEST_CASE (j2k_decoder_layers_test)
+{
+	unsigned int seed = 43;
+	auto frame = random_frame (&seed);
+
+	dcp::J2KDecoder decoder;
+	decoder.set_layers (1);
+	BOOST_CHECK_EQUAL (decoder.layers(), 1);
+	check_same (decoder.decode(frame), dcp::decompress_j2k(frame, 0));
+}
+
+
+#endif
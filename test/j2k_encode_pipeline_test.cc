@@ -0,0 +1,140 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+
+#include "exceptions.h"
+#include "j2k_encode_pipeline.h"
+#include "mono_picture_asset.h"
+#include "mono_picture_asset_writer.h"
+#include "openjpeg_image.h"
+#include "j2k_transcode.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <thread>
+
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+
+/* J2KEncodePipeline is not available with OpenJPEG 1 */
+#ifndef LIBDCP_OPENJPEG1
+
+
+/** Check that frames pushed out of order from several threads are written in order, and the same as
+ *  if they had been encoded and written one by one.
+ */
+BOOST_AUTO_TEST_CASE (j2k_encode_pipeline_test)
+{
+	int const frames = 24;
+
+	vector<string> reference;
+	{
+		auto asset = make_shared<dcp::MonoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+		auto writer = asset->start_write ("build/test/j2k_encode_pipeline_test1.mxf", false);
+		for (int i = 0; i < frames; ++i) {
+			/* Each frame has its own seed so that the pushers below can make it again */
+			unsigned int seed = i;
+			auto data = dcp::compress_j2k (random_image(&seed), 100000000, 24, false, false);
+			reference.push_back (writer->write(data.data(), data.size()).hash);
+		}
+		writer->finalize ();
+	}
+
+	auto asset = make_shared<dcp::MonoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+	auto writer = asset->start_write ("build/test/j2k_encode_pipeline_test2.mxf", false);
+
+	/* This is called from the pipeline's threads, so just record what happens and check it afterwards */
+	vector<int64_t> indices;
+	vector<string> hashes;
+	dcp::J2KEncodePipeline pipeline (writer, 4, 100000000, 24, false, false, 6, [&indices, &hashes](int64_t index, dcp::FrameInfo info) {
+		indices.push_back (index);
+		hashes.push_back (info.hash);
+	});
+
+	vector<std::thread> pushers;
+	for (int i = 0; i < 3; ++i) {
+		/* Each thread pushes every third frame, backwards within each group of 6 */
+		pushers.push_back (std::thread([&pipeline, i]() {
+			for (int j = 0; j < frames; j += 6) {
+				for (int k = 5; k >= 0; --k) {
+					if ((j + k) % 3 == i) {
+						unsigned int seed = j + k;
+						pipeline.push (j + k, random_image(&seed));
+					}
+				}
+			}
+		}));
+	}
+
+	for (auto& i: pushers) {
+		i.join ();
+	}
+
+	pipeline.flush ();
+	writer->finalize ();
+
+	BOOST_REQUIRE_EQUAL (indices.size(), static_cast<size_t>(frames));
+	for (int i = 0; i < frames; ++i) {
+		BOOST_CHECK_EQUAL (indices[i], i);
+	}
+	BOOST_CHECK (hashes == reference);
+	BOOST_CHECK_EQUAL (asset->intrinsic_duration(), frames);
+}
+
+
+/** Check that flush() throws, rather than waiting for ever, if a frame was never pushed */
+BOOST_AUTO_TEST_CASE (j2k_encode_pipeline_gap_test)
+{
+	auto asset = make_shared<dcp::MonoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+	auto writer = asset->start_write ("build/test/j2k_encode_pipeline_gap_test.mxf", false);
+
+	vector<int64_t> indices;
+	dcp::J2KEncodePipeline pipeline (writer, 2, 100000000, 24, false, false, 6, [&indices](int64_t index, dcp::FrameInfo) {
+		indices.push_back (index);
+	});
+
+	unsigned int seed = 42;
+	pipeline.push (0, random_image(&seed));
+	pipeline.push (2, random_image(&seed));
+
+	BOOST_CHECK_THROW (pipeline.flush(), dcp::MiscError);
+	BOOST_CHECK (indices == vector<int64_t>{0});
+}
+
+
+#endif
@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "j2k_transcode.h"
+#include "openjpeg_image.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+
+
+using std::vector;
+
+
+/* J2KEncoder is not available with OpenJPEG 1 */
+#ifndef LIBDCP_OPENJPEG1
+
+
+static vector<uint8_t>
+copy (dcp::Data const& data)
+{
+	return vector<uint8_t>(data.data(), data.data() + data.size());
+}
+
+
+/** Check that a J2KEncoder gives the same results as compress_j2k, both when the caller lets go
+ *  of each frame before asking for the next (so the encoder can re-use its buffer) and when
+ *  it keeps hold of them.
+ */
+BOOST_AUTO_TEST_CASE (j2k_encoder_test)
+{
+	int const frames = 4;
+
+	/* Each pass starts from the same seed so that it encodes the same images */
+	unsigned int seed = 42;
+	vector<vector<uint8_t>> reference;
+	for (int i = 0; i < frames; ++i) {
+		reference.push_back (copy(dcp::compress_j2k(random_image(&seed), 100000000, 24, false, false)));
+	}
+
+	dcp::J2KEncoder encoder (100000000, 24, false, false);
+
+	seed = 42;
+	for (int i = 0; i < frames; ++i) {
+		auto data = encoder.encode (random_image(&seed));
+		BOOST_CHECK (copy(data) == reference[i]);
+	}
+
+	seed = 42;
+	vector<dcp::ArrayData> kept;
+	for (int i = 0; i < frames; ++i) {
+		kept.push_back (encoder.encode(random_image(&seed)));
+	}
+	for (int i = 0; i < frames; ++i) {
+		BOOST_CHECK (copy(kept[i]) == reference[i]);
+	}
+}
+
+
+/** Check that a J2KEncoder copes with frames which are bigger than its initial buffer.  With no bandwidth
+ *  given it starts with a small buffer but OpenJPEG will use its default limit for the cinema profile,
+ *  which is much bigger.
+ */
+BOOST_AUTO_TEST_CASE (j2k_encoder_grow_test)
+{
+	unsigned int seed = 42;
+	auto image = random_image (&seed);
+
+	dcp::J2KEncoder encoder (0, 24, false, false);
+	auto reference = copy (dcp::compress_j2k(image, 0, 24, false, false));
+	BOOST_CHECK (copy(encoder.encode(image)) == reference);
+}
+
+
+#endif
@@ -33,10 +33,14 @@
 
 
 #include "array_data.h"
+#include "font_asset.h"
+#include "hash_assets.h"
 #include "util.h"
 #include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
 #include <sys/time.h>
+#include <memory>
+#include <vector>
 
 
 void progress (float)
@@ -60,4 +64,61 @@ BOOST_AUTO_TEST_CASE (make_digest_test)
 
 	/* Hash it */
 	BOOST_CHECK_EQUAL (dcp::make_digest("build/test/random", boost::bind(&progress, _1)), "GKbk/V3fcRtP5MaPdSmAGNbKkaU=");
+
+	/* Hash it again, reading it in the other ways */
+	for (auto io: { dcp::DigestIO::STREAM, dcp::DigestIO::DIRECT, dcp::DigestIO::MMAP }) {
+		BOOST_CHECK_EQUAL (dcp::make_digest("build/test/random", boost::bind(&progress, _1), io), "GKbk/V3fcRtP5MaPdSmAGNbKkaU=");
+	}
+}
+
+
+/** Check that the different ways of reading files give the same digests with awkward file and block sizes */
+BOOST_AUTO_TEST_CASE (make_digest_io_test)
+{
+	for (auto size: { 0, 1, 4095, 4096, 4097, 1000000 }) {
+		dcp::ArrayData data (size);
+		for (int i = 0; i < size; ++i) {
+			data.data()[i] = i & 0xff;
+		}
+		data.write ("build/test/make_digest_io_test");
+
+		auto const reference = dcp::make_digest (data);
+		for (auto io: { dcp::DigestIO::STANDARD, dcp::DigestIO::STREAM, dcp::DigestIO::DIRECT, dcp::DigestIO::MMAP }) {
+			for (auto block_size: { 1, 4096, 12288, 8 * 1024 * 1024 }) {
+				BOOST_CHECK_EQUAL (dcp::make_digest("build/test/make_digest_io_test", {}, io, block_size), reference);
+			}
+		}
+	}
+}
+
+
+/** Check that hashing assets in parallel gives the same answers as doing them one at a time */
+BOOST_AUTO_TEST_CASE (hash_assets_test)
+{
+	std::vector<boost::filesystem::path> files = {
+		"test/data/dummy.ttf",
+		"test/data/flat_red.j2c",
+		"test/data/32x32_red_square.j2c",
+		"test/data/subs.mxf",
+		"test/data/dummy.mxf",
+		"test/data/flat_red.png"
+	};
+
+	std::vector<std::shared_ptr<const dcp::Asset>> assets;
+	for (auto i: files) {
+		assets.push_back (std::make_shared<dcp::FontAsset>(dcp::make_uuid(), i));
+	}
+	/* The same asset twice should only be hashed once */
+	assets.push_back (assets.front());
+
+	float last_progress = 0;
+	dcp::hash_assets (assets, 4, [&last_progress](float p) {
+		BOOST_CHECK (p >= last_progress);
+		last_progress = p;
+	});
+	BOOST_CHECK_CLOSE (last_progress, 1, 0.001);
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		BOOST_CHECK_EQUAL (assets[i]->hash(), dcp::make_digest(files[i], {}));
+	}
 }
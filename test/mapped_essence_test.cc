@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "exceptions.h"
+#include "mono_picture_asset.h"
+#include "mono_picture_asset_reader.h"
+#include "mono_picture_frame.h"
+#include "picture_asset_writer.h"
+#include "stereo_picture_asset.h"
+#include "stereo_picture_asset_reader.h"
+#include "stereo_picture_frame.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+
+
+using std::make_shared;
+using std::shared_ptr;
+
+
+static bool
+same (shared_ptr<const dcp::Data> a, shared_ptr<const dcp::Data> b)
+{
+	return a->size() == b->size() && std::equal(a->data(), a->data() + a->size(), b->data());
+}
+
+
+/** Check that a mapped reader for a 2D asset gives the same frames as a normal one */
+BOOST_AUTO_TEST_CASE (mapped_essence_mono_test)
+{
+	boost::filesystem::path const file = "build/test/mapped_essence_mono_test.mxf";
+	int const frames = 4;
+
+	auto mp = random_picture_asset (file, frames);
+	/* There's no frame index, so frames must be read in the usual way */
+	BOOST_CHECK (!mp->start_read(true)->mapped());
+
+	mp = random_picture_asset (file, frames, true);
+
+	auto reader = mp->start_read ();
+	BOOST_CHECK (!reader->mapped());
+	auto mapped = mp->start_read (true);
+#ifndef LIBDCP_WINDOWS
+	BOOST_CHECK (mapped->mapped());
+#endif
+
+	shared_ptr<const dcp::MonoPictureFrame> first;
+	for (int i = 0; i < frames; ++i) {
+		auto frame = mapped->get_frame (i);
+		BOOST_CHECK (same(frame, reader->get_frame(i)));
+		if (i == 0) {
+			first = frame;
+		}
+	}
+
+	BOOST_CHECK_THROW (mapped->get_frame(frames), dcp::ReadError);
+
+	/* A frame can outlive its reader */
+	mapped.reset ();
+	BOOST_CHECK (same(first, reader->get_frame(0)));
+}
+
+
+/** Check that a mapped reader for a 3D asset gives the same frames as a normal one */
+BOOST_AUTO_TEST_CASE (mapped_essence_stereo_test)
+{
+	boost::filesystem::path const file = "build/test/mapped_essence_stereo_test.mxf";
+	int const frames = 2;
+
+	auto mp = make_shared<dcp::StereoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+	auto writer = mp->start_write (file, false);
+	writer->set_write_frame_index (true);
+	unsigned int seed = 42;
+	for (int i = 0; i < frames * 2; ++i) {
+		writer->write (random_frame(&seed));
+	}
+	writer->finalize ();
+
+	auto reader = mp->start_read ();
+	auto mapped = mp->start_read (true);
+#ifndef LIBDCP_WINDOWS
+	BOOST_CHECK (mapped->mapped());
+#endif
+
+	for (int i = 0; i < frames; ++i) {
+		auto a = mapped->get_frame (i);
+		auto b = reader->get_frame (i);
+		BOOST_CHECK (same(a->left(), b->left()));
+		BOOST_CHECK (same(a->right(), b->right()));
+		BOOST_CHECK (!same(a->left(), a->right()));
+	}
+
+	BOOST_CHECK_THROW (mapped->get_frame(frames), dcp::ReadError);
+}
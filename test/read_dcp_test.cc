@@ -32,13 +32,24 @@
 */
 
 #include <boost/test/unit_test.hpp>
+#include <boost/algorithm/string.hpp>
 #include <boost/optional/optional_io.hpp>
 #include "dcp.h"
 #include "cpl.h"
+#include "exceptions.h"
+#include "reel_file_asset.h"
 #include "stream_operators.h"
+#include "test.h"
+#include "verify.h"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
 
+using std::function;
 using std::list;
 using std::shared_ptr;
+using std::string;
 
 /** Read a SMPTE DCP that is in git and make sure that basic stuff is read in correctly */
 BOOST_AUTO_TEST_CASE (read_dcp_test1)
@@ -71,3 +82,199 @@ BOOST_AUTO_TEST_CASE (read_dcp_test2)
 	BOOST_REQUIRE (d.standard());
 	BOOST_CHECK_EQUAL (d.standard(), dcp::Standard::INTEROP);
 }
+
+
+/** Check that opening a DCP's MXFs on several threads gives the same result as opening them one by one */
+BOOST_AUTO_TEST_CASE (read_dcp_threads_test)
+{
+	for (auto dir: { "test/ref/DCP/dcp_test1", "test/ref/DCP/dcp_test3" }) {
+		dcp::DCP serial (dir);
+		std::vector<dcp::VerificationNote> serial_notes;
+		serial.read (&serial_notes);
+
+		dcp::DCP parallel (dir);
+		std::vector<dcp::VerificationNote> parallel_notes;
+		parallel.read (&parallel_notes, false, 4);
+
+		BOOST_CHECK (serial_notes == parallel_notes);
+
+		auto serial_assets = serial.cpls()[0]->reel_file_assets();
+		auto parallel_assets = parallel.cpls()[0]->reel_file_assets();
+		BOOST_REQUIRE_EQUAL (serial_assets.size(), parallel_assets.size());
+		for (size_t i = 0; i < serial_assets.size(); ++i) {
+			BOOST_CHECK_EQUAL (serial_assets[i]->asset_ref().resolved(), parallel_assets[i]->asset_ref().resolved());
+			if (parallel_assets[i]->asset_ref().resolved()) {
+				BOOST_CHECK (parallel_assets[i]->asset_ref()->file() == serial_assets[i]->asset_ref()->file());
+			}
+		}
+	}
+}
+
+
+/** Check that a lazy read makes assets only when they are asked for, and that they are the same as those from a normal read */
+BOOST_AUTO_TEST_CASE (read_dcp_lazy_test)
+{
+	for (auto dir: { "test/ref/DCP/dcp_test1", "test/ref/DCP/dcp_test3" }) {
+		dcp::DCP eager (dir);
+		eager.read ();
+
+		dcp::DCP lazy (dir);
+		std::vector<dcp::VerificationNote> notes;
+		lazy.read (&notes, false, 1, true);
+		BOOST_CHECK (notes.empty());
+
+		auto eager_assets = eager.cpls()[0]->reel_file_assets();
+		auto lazy_assets = lazy.cpls()[0]->reel_file_assets();
+		BOOST_REQUIRE_EQUAL (eager_assets.size(), lazy_assets.size());
+		BOOST_REQUIRE (!lazy_assets.empty());
+
+		for (auto i: lazy_assets) {
+			BOOST_CHECK (i->asset_ref().resolved());
+			BOOST_CHECK (!i->asset_ref().loaded());
+		}
+
+		for (size_t i = 0; i < lazy_assets.size(); ++i) {
+			auto asset = lazy_assets[i]->asset_ref().asset();
+			BOOST_CHECK (lazy_assets[i]->asset_ref().loaded());
+			BOOST_CHECK_EQUAL (asset->id(), eager_assets[i]->asset_ref()->id());
+			BOOST_CHECK (asset->file() == eager_assets[i]->asset_ref()->file());
+			/* Asking again gives the same object */
+			BOOST_CHECK (lazy_assets[i]->asset_ref().asset() == asset);
+		}
+	}
+}
+
+
+/** Copy dcp_test1 to build/test/name and pass its CPL through mangle
+ *  @return Path to the CPL in the copy
+ */
+static boost::filesystem::path
+mangle_cpl (string name, function<string (string)> mangle)
+{
+	auto const dir = boost::filesystem::path("build/test") / name;
+	boost::filesystem::remove_all (dir);
+	boost::filesystem::create_directories (dir);
+	for (auto i: boost::filesystem::directory_iterator("test/ref/DCP/dcp_test1")) {
+		boost::filesystem::copy_file (i.path(), dir / i.path().filename());
+	}
+
+	auto const cpl = find_file (dir, "cpl_");
+	std::ifstream in (cpl.string().c_str());
+	string const content ((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close ();
+
+	std::ofstream out (cpl.string().c_str(), std::ios::trunc);
+	out << mangle (content);
+	return cpl;
+}
+
+
+/** Check that reading the DCP containing cpl throws the ReadError that we give for a CPL which is not well-formed XML */
+static void
+check_xml_error (boost::filesystem::path cpl)
+{
+	dcp::DCP dcp (cpl.parent_path());
+	BOOST_CHECK_EXCEPTION (
+		dcp.read(),
+		dcp::ReadError,
+		[cpl](dcp::ReadError const& e) {
+			return boost::algorithm::starts_with(e.message(), "XML error in") && e.message().find(cpl.filename().string()) != string::npos && e.detail();
+		});
+}
+
+
+BOOST_AUTO_TEST_CASE (read_dcp_truncated_cpl_test)
+{
+	/* Cut off in the middle of the root node's start tag */
+	check_xml_error (
+		mangle_cpl("read_dcp_truncated_cpl_test1", [](string content) {
+			return content.substr(0, content.find("<CompositionPlaylist") + 12);
+		})
+	);
+
+	/* Cut off half-way through */
+	check_xml_error (
+		mangle_cpl("read_dcp_truncated_cpl_test2", [](string content) {
+			return content.substr(0, content.length() / 2);
+		})
+	);
+}
+
+
+BOOST_AUTO_TEST_CASE (read_dcp_non_xml_cpl_test)
+{
+	check_xml_error (
+		mangle_cpl("read_dcp_non_xml_cpl_test", [](string) {
+			return string("This is not XML\n");
+		})
+	);
+}
+
+
+/** Check a CPL whose root node can be found but which is not well-formed later on */
+BOOST_AUTO_TEST_CASE (read_dcp_malformed_cpl_test)
+{
+	check_xml_error (
+		mangle_cpl("read_dcp_malformed_cpl_test", [](string content) {
+			boost::algorithm::replace_all (content, "</CompositionPlaylist>", "</CompositionPlaylis>");
+			return content;
+		})
+	);
+}
+
+
+/** Check that a 3D asset marked as 2D is noted in the same place when its MXF is opened on another thread */
+BOOST_AUTO_TEST_CASE (read_dcp_threads_threed_marked_as_twod_test)
+{
+	auto const dir = private_test / "data" / "xm";
+
+	dcp::DCP serial (dir);
+	std::vector<dcp::VerificationNote> serial_notes;
+	serial.read (&serial_notes, true);
+
+	dcp::DCP parallel (dir);
+	std::vector<dcp::VerificationNote> parallel_notes;
+	parallel.read (&parallel_notes, true, 4);
+
+	BOOST_CHECK (
+		std::find_if(serial_notes.begin(), serial_notes.end(), [](dcp::VerificationNote const& note) {
+			return note.code() == dcp::VerificationNote::Code::THREED_ASSET_MARKED_AS_TWOD;
+		}) != serial_notes.end()
+		);
+	BOOST_CHECK (serial_notes == parallel_notes);
+}
+
+
+/** Check that when opening MXFs on several threads the error that is thrown is the one that we would get
+ *  from a single-threaded read, even if there are other errors in the DCP.
+ */
+BOOST_AUTO_TEST_CASE (read_dcp_threads_error_test)
+{
+	/* In dcp_test1's ASSETMAP, sorted by ID, video.mxf comes before the CPL and audio.mxf comes after it */
+	auto const cpl = mangle_cpl("read_dcp_threads_error_test", [](string content) {
+		return content.substr(0, content.length() / 2);
+	});
+	auto const dir = cpl.parent_path();
+
+	auto corrupt = [dir](string mxf) {
+		boost::filesystem::remove (dir / mxf);
+		std::ofstream out ((dir / mxf).string().c_str());
+		out << "This is not an MXF\n";
+	};
+
+	corrupt ("audio.mxf");
+	for (auto threads: { 1, 4 }) {
+		dcp::DCP dcp (dir);
+		BOOST_CHECK_EXCEPTION (dcp.read(nullptr, false, threads), dcp::ReadError, [](dcp::ReadError const& e) {
+			return boost::algorithm::starts_with(e.message(), "XML error in");
+		});
+	}
+
+	corrupt ("video.mxf");
+	for (auto threads: { 1, 4 }) {
+		dcp::DCP dcp (dir);
+		BOOST_CHECK_EXCEPTION (dcp.read(nullptr, false, threads), dcp::ReadError, [](dcp::ReadError const& e) {
+			return e.message() == "Could not find essence type";
+		});
+	}
+}
@@ -0,0 +1,186 @@
+/*
+    Copyright (C) 2021 Carl Hetherington <cth@carlh.net>
+
+    This file is part of libdcp.
+
+    libdcp is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    libdcp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libdcp.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give
+    permission to link the code of portions of this program with the
+    OpenSSL library under certain conditions as described in each
+    individual source file, and distribute linked combinations
+    including the two.
+
+    You must obey the GNU General Public License in all respects
+    for all of the code used other than OpenSSL.  If you modify
+    file(s) with this exception, you may extend this exception to your
+    version of the file(s), but you are not obligated to do so.  If you
+    do not wish to do so, delete this exception statement from your
+    version.  If you delete this exception statement from all source
+    files in the program, then also delete it here.
+*/
+
+
+#include "atmos_asset.h"
+#include "atmos_asset_reader.h"
+#include "atmos_asset_writer.h"
+#include "exceptions.h"
+#include "mono_picture_asset.h"
+#include "mono_picture_asset_reader.h"
+#include "mono_picture_frame.h"
+#include "picture_asset_writer.h"
+#include "sound_asset.h"
+#include "sound_asset_reader.h"
+#include "sound_asset_writer.h"
+#include "sound_frame.h"
+#include "stereo_picture_asset.h"
+#include "stereo_picture_asset_reader.h"
+#include "stereo_picture_frame.h"
+#include "test.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+
+using std::function;
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+
+
+/** Check that @p read gives the same bytes as @p frame, and that it throws ReadError
+ *  if it is not given enough room.
+ *  @param read Function to call read_frame_into with some memory and its capacity.
+ */
+template <class F>
+static void
+check_read_into (shared_ptr<const F> frame, function<int (uint8_t*, int)> read)
+{
+	vector<uint8_t> data (frame->size() + 64);
+	BOOST_REQUIRE_EQUAL (read(data.data(), data.size()), frame->size());
+	BOOST_CHECK (std::equal(frame->data(), frame->data() + frame->size(), data.data()));
+
+	dcp::ASDCPErrorSuspender sus;
+	BOOST_CHECK_THROW (read(data.data(), frame->size() - 1), dcp::ReadError);
+}
+
+
+BOOST_AUTO_TEST_CASE (read_frame_into_mono_test)
+{
+	int const frames = 3;
+	auto mp = random_picture_asset ("build/test/read_frame_into_mono_test.mxf", frames);
+	auto reader = mp->start_read ();
+
+	for (int i = 0; i < frames; ++i) {
+		check_read_into<dcp::MonoPictureFrame> (reader->get_frame(i), [reader, i](uint8_t* data, int capacity) {
+			return reader->read_frame_into (i, data, capacity);
+		});
+	}
+
+	vector<uint8_t> data (1024 * 1024);
+	dcp::ASDCPErrorSuspender sus;
+	BOOST_CHECK_THROW (reader->read_frame_into(frames, data.data(), data.size()), dcp::ReadError);
+}
+
+
+BOOST_AUTO_TEST_CASE (read_frame_into_stereo_test)
+{
+	int const frames = 2;
+
+	auto mp = make_shared<dcp::StereoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+	auto writer = mp->start_write ("build/test/read_frame_into_stereo_test.mxf", false);
+	unsigned int seed = 42;
+	for (int i = 0; i < frames * 2; ++i) {
+		writer->write (random_frame(&seed));
+	}
+	writer->finalize ();
+
+	auto reader = mp->start_read ();
+
+	for (int i = 0; i < frames; ++i) {
+		auto frame = reader->get_frame (i);
+		check_read_into<dcp::Data> (frame->left(), [reader, i](uint8_t* data, int capacity) {
+			return reader->read_frame_into (i, dcp::Eye::LEFT, data, capacity);
+		});
+		check_read_into<dcp::Data> (frame->right(), [reader, i](uint8_t* data, int capacity) {
+			return reader->read_frame_into (i, dcp::Eye::RIGHT, data, capacity);
+		});
+	}
+
+	vector<uint8_t> data (1024 * 1024);
+	dcp::ASDCPErrorSuspender sus;
+	BOOST_CHECK_THROW (reader->read_frame_into(frames, dcp::Eye::LEFT, data.data(), data.size()), dcp::ReadError);
+}
+
+
+BOOST_AUTO_TEST_CASE (read_frame_into_sound_test)
+{
+	int const frames = 3;
+	int const channels = 6;
+	int const samples_per_frame = 2000;
+
+	auto ms = make_shared<dcp::SoundAsset>(dcp::Fraction(24, 1), 48000, channels, dcp::LanguageTag("en-US"), dcp::Standard::SMPTE);
+	auto writer = ms->start_write ("build/test/read_frame_into_sound_test.mxf");
+
+	unsigned int seed = 42;
+	vector<vector<float>> samples (channels, vector<float>(samples_per_frame));
+	vector<float const *> pointers;
+	for (auto const& i: samples) {
+		pointers.push_back (i.data());
+	}
+
+	for (int i = 0; i < frames; ++i) {
+		for (auto& j: samples) {
+			for (auto& k: j) {
+				k = static_cast<float>(rand_r(&seed)) / RAND_MAX * 2 - 1;
+			}
+		}
+		writer->write (pointers.data(), samples_per_frame);
+	}
+	writer->finalize ();
+
+	auto reader = ms->start_read ();
+
+	for (int i = 0; i < frames; ++i) {
+		check_read_into<dcp::SoundFrame> (reader->get_frame(i), [reader, i](uint8_t* data, int capacity) {
+			return reader->read_frame_into (i, data, capacity);
+		});
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE (read_frame_into_atmos_test)
+{
+	int const frames = 3;
+
+	auto ma = make_shared<dcp::AtmosAsset>(dcp::Fraction(24, 1), 0, 64, 118, 1);
+	auto writer = ma->start_write ("build/test/read_frame_into_atmos_test.mxf");
+
+	/* The reader does not care what the frames contain, so J2K data will do */
+	unsigned int seed = 42;
+	for (int i = 0; i < frames; ++i) {
+		auto frame = random_frame (&seed);
+		writer->write (frame.data(), frame.size());
+	}
+	writer->finalize ();
+
+	auto reader = ma->start_read ();
+
+	for (int i = 0; i < frames; ++i) {
+		check_read_into<dcp::AtmosFrame> (reader->get_frame(i), [reader, i](uint8_t* data, int capacity) {
+			return reader->read_frame_into (i, data, capacity);
+		});
+	}
+}
@@ -34,6 +34,7 @@
 #include "rgb_xyz.h"
 #include "openjpeg_image.h"
 #include "colour_conversion.h"
+#include "fixed_point_colour_conversion.h"
 #include "stream_operators.h"
 #include <boost/test/unit_test.hpp>
 #include <boost/bind.hpp>
@@ -210,3 +211,131 @@ BOOST_AUTO_TEST_CASE (rgb_xyz_round_trip_test)
 	}
 #endif
 }
+
+
+/** Check that every rgb_to_xyz kernel that this CPU supports gives exactly the same results as the scalar one */
+BOOST_AUTO_TEST_CASE (rgb_xyz_kernels_test)
+{
+	srand (0);
+	/* Odd width so that the kernels have some left-over pixels to deal with at the end of each line */
+	dcp::Size const size (641, 480);
+
+	scoped_array<uint8_t> rgb (new uint8_t[size.width * size.height * 6]);
+	for (int y = 0; y < size.height; ++y) {
+		uint16_t* p = reinterpret_cast<uint16_t*> (rgb.get() + y * size.width * 6);
+		for (int x = 0; x < size.width; ++x) {
+			for (int c = 0; c < 3; ++c) {
+				*p = rand () & 0xffff;
+				++p;
+			}
+		}
+	}
+
+	for (auto const& conversion: { dcp::ColourConversion::srgb_to_xyz(), dcp::ColourConversion::rec2020_to_xyz(), dcp::ColourConversion::s_gamut3_to_xyz() }) {
+		notes.clear ();
+		auto reference = dcp::rgb_to_xyz (
+			rgb.get(), size, size.width * 6, conversion, dcp::RGBToXYZKernel::SCALAR, boost::optional<dcp::NoteHandler>(boost::bind(&note_handler, _1, _2))
+			);
+		auto const reference_notes = notes;
+
+		for (auto kernel: { dcp::RGBToXYZKernel::SSE2, dcp::RGBToXYZKernel::AVX2 }) {
+			if (kernel > dcp::best_rgb_to_xyz_kernel()) {
+				continue;
+			}
+			notes.clear ();
+			auto xyz = dcp::rgb_to_xyz (
+				rgb.get(), size, size.width * 6, conversion, kernel, boost::optional<dcp::NoteHandler>(boost::bind(&note_handler, _1, _2))
+				);
+			for (int c = 0; c < 3; ++c) {
+				for (int i = 0; i < size.width * size.height; ++i) {
+					BOOST_REQUIRE_EQUAL (xyz->data(c)[i], reference->data(c)[i]);
+				}
+			}
+			BOOST_CHECK (notes == reference_notes);
+		}
+	}
+}
+
+
+/** Check that the multi-threaded conversions give the same results, and the same notes, as the single-threaded ones */
+BOOST_AUTO_TEST_CASE (rgb_xyz_threads_test)
+{
+	srand (0);
+	dcp::Size const size (640, 481);
+
+	scoped_array<uint8_t> rgb (new uint8_t[size.width * size.height * 6]);
+	for (int i = 0; i < size.width * size.height * 6; ++i) {
+		rgb[i] = rand () & 0xff;
+	}
+
+	auto const conversion = dcp::ColourConversion::rec2020_to_xyz ();
+
+	notes.clear ();
+	auto xyz = dcp::rgb_to_xyz (rgb.get(), size, size.width * 6, conversion, boost::optional<dcp::NoteHandler>(boost::bind(&note_handler, _1, _2)));
+	auto const single_notes = notes;
+
+	for (auto threads: { 2, 3, 16, 1000 }) {
+		notes.clear ();
+		auto threaded = dcp::rgb_to_xyz (rgb.get(), size, size.width * 6, conversion, threads, boost::optional<dcp::NoteHandler>(boost::bind(&note_handler, _1, _2)));
+		for (int c = 0; c < 3; ++c) {
+			BOOST_REQUIRE (std::equal(xyz->data(c), xyz->data(c) + size.width * size.height, threaded->data(c)));
+		}
+		BOOST_CHECK (notes == single_notes);
+	}
+
+	/* Make some XYZ values out of range so that xyz_to_rgb has something to note */
+	for (int i = 0; i < size.height; i += 7) {
+		xyz->data(i % 3)[i * size.width + i] = 4096 + i;
+	}
+
+	scoped_array<uint8_t> single_rgb (new uint8_t[size.width * size.height * 6]);
+	notes.clear ();
+	dcp::xyz_to_rgb (xyz, conversion, single_rgb.get(), size.width * 6, boost::optional<dcp::NoteHandler>(boost::bind(&note_handler, _1, _2)));
+	auto const single_rgb_notes = notes;
+	BOOST_CHECK (!single_rgb_notes.empty());
+
+	scoped_array<uint8_t> threaded_rgb (new uint8_t[size.width * size.height * 6]);
+	notes.clear ();
+	dcp::xyz_to_rgb (xyz, conversion, threaded_rgb.get(), size.width * 6, 4, boost::optional<dcp::NoteHandler>(boost::bind(&note_handler, _1, _2)));
+	BOOST_CHECK (notes == single_rgb_notes);
+	BOOST_REQUIRE (std::equal(single_rgb.get(), single_rgb.get() + size.width * size.height * 6, threaded_rgb.get()));
+}
+
+
+/** Check that the fixed-point conversions are close to the exact ones */
+BOOST_AUTO_TEST_CASE (rgb_xyz_fixed_point_test)
+{
+	srand (0);
+	dcp::Size const size (640, 480);
+
+	scoped_array<uint8_t> rgb (new uint8_t[size.width * size.height * 6]);
+	for (int y = 0; y < size.height; ++y) {
+		uint16_t* p = reinterpret_cast<uint16_t*> (rgb.get() + y * size.width * 6);
+		for (int x = 0; x < size.width; ++x) {
+			/* Write a 12-bit random number for each component */
+			for (int c = 0; c < 3; ++c) {
+				*p = (rand () & 0xfff) << 4;
+				++p;
+			}
+		}
+	}
+
+	auto const& conversion = dcp::ColourConversion::srgb_to_xyz ();
+	dcp::FixedPointColourConversion fixed (conversion);
+
+	auto exact_xyz = dcp::rgb_to_xyz (rgb.get(), size, size.width * 6, conversion);
+	auto fixed_xyz = dcp::rgb_to_xyz (rgb.get(), size, size.width * 6, fixed, 2);
+	for (int c = 0; c < 3; ++c) {
+		for (int i = 0; i < size.width * size.height; ++i) {
+			BOOST_REQUIRE (std::abs(exact_xyz->data(c)[i] - fixed_xyz->data(c)[i]) <= 1);
+		}
+	}
+
+	scoped_array<uint8_t> exact_rgba (new uint8_t[size.width * size.height * 4]);
+	scoped_array<uint8_t> fixed_rgba (new uint8_t[size.width * size.height * 4]);
+	dcp::xyz_to_rgba (exact_xyz, conversion, exact_rgba.get(), size.width * 4);
+	dcp::xyz_to_rgba (exact_xyz, fixed, fixed_rgba.get(), size.width * 4, 3);
+	for (int i = 0; i < size.width * size.height * 4; ++i) {
+		BOOST_REQUIRE (std::abs(exact_rgba[i] - fixed_rgba[i]) <= 1);
+	}
+}
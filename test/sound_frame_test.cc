@@ -38,8 +38,10 @@
 #include "sound_asset_reader.h"
 #include "exceptions.h"
 #include <sndfile.h>
+#include <vector>
 
 using std::shared_ptr;
+using std::vector;
 
 BOOST_AUTO_TEST_CASE (sound_frame_test)
 {
@@ -99,3 +101,23 @@ BOOST_AUTO_TEST_CASE (sound_frame_test2)
 
 	BOOST_CHECK_THROW (asset.start_read()->get_frame (99999999), dcp::ReadError);
 }
+
+
+BOOST_AUTO_TEST_CASE (sound_frame_read_into_test)
+{
+	dcp::SoundAsset asset (
+		private_test /
+		"TONEPLATES-SMPTE-PLAINTEXT_TST_F_XX-XX_ITL-TD_51-XX_2K_WOE_20111001_WOE_OV/pcm_95734608-5d47-4d3f-bf5f-9e9186b66afa_.mxf"
+		);
+
+	auto reader = asset.start_read ();
+	auto frame = reader->get_frame (42);
+
+	vector<uint8_t> data (frame->size() + 64);
+	BOOST_REQUIRE_EQUAL (reader->read_frame_into(42, data.data(), data.size()), frame->size());
+	BOOST_CHECK (memcmp(data.data(), frame->data(), frame->size()) == 0);
+
+	dcp::ASDCPErrorSuspender sus;
+	BOOST_CHECK_THROW (reader->read_frame_into(42, data.data(), frame->size() - 1), dcp::ReadError);
+	BOOST_CHECK_THROW (reader->read_frame_into(99999999, data.data(), data.size()), dcp::ReadError);
+}
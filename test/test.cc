@@ -511,6 +511,26 @@ black_image (dcp::Size size)
 }
 
 
+shared_ptr<dcp::OpenJPEGImage>
+random_image (unsigned int* seed)
+{
+	auto image = make_shared<dcp::OpenJPEGImage>(dcp::Size(1998, 1080));
+	for (int c = 0; c < 3; ++c) {
+		for (int p = 0; p < (1998 * 1080); ++p) {
+			image->data(c)[p] = rand_r(seed) & 0xfff;
+		}
+	}
+	return image;
+}
+
+
+dcp::ArrayData
+random_frame (unsigned int* seed)
+{
+	return dcp::compress_j2k (random_image(seed), 100000000, 24, false, false);
+}
+
+
 shared_ptr<dcp::ReelAsset>
 black_picture_asset (boost::filesystem::path dir, int frames)
 {
@@ -531,6 +551,24 @@ black_picture_asset (boost::filesystem::path dir, int frames)
 }
 
 
+shared_ptr<dcp::MonoPictureAsset>
+random_picture_asset (boost::filesystem::path file, int frames, bool frame_index, vector<dcp::FrameInfo>* infos)
+{
+	auto asset = make_shared<dcp::MonoPictureAsset>(dcp::Fraction(24, 1), dcp::Standard::SMPTE);
+	auto writer = asset->start_write (file, false);
+	writer->set_write_frame_index (frame_index);
+	unsigned int seed = 42;
+	for (int i = 0; i < frames; ++i) {
+		auto info = writer->write (random_frame(&seed));
+		if (infos) {
+			infos->push_back (info);
+		}
+	}
+	writer->finalize ();
+	return asset;
+}
+
+
 boost::filesystem::path
 find_file (boost::filesystem::path dir, string filename_part)
 {
@@ -18,6 +18,7 @@
 */
 
 
+#include "array_data.h"
 #include "cpl.h"
 #include "dcp.h"
 #include "reel.h"
@@ -33,6 +34,7 @@ namespace xmlpp {
 
 namespace dcp {
 	class DCP;
+	struct FrameInfo;
 	class MonoPictureAsset;
 	class SoundAsset;
 }
@@ -72,7 +74,21 @@ extern std::shared_ptr<dcp::DCP> make_simple_with_smpte_subs (boost::filesystem:
 extern std::shared_ptr<dcp::DCP> make_simple_with_interop_ccaps (boost::filesystem::path path);
 extern std::shared_ptr<dcp::DCP> make_simple_with_smpte_ccaps (boost::filesystem::path path);
 extern std::shared_ptr<dcp::OpenJPEGImage> black_image (dcp::Size size = dcp::Size(1998, 1080));
+/** @return a 1998x1080 XYZ image full of 12-bit values from rand_r(seed) */
+extern std::shared_ptr<dcp::OpenJPEGImage> random_image (unsigned int* seed);
+/** @return random_image(seed) compressed to JPEG2000 at 100Mbit/s */
+extern dcp::ArrayData random_frame (unsigned int* seed);
 extern std::shared_ptr<dcp::ReelAsset> black_picture_asset (boost::filesystem::path dir, int frames = 24);
+/** Write a 24fps SMPTE MonoPictureAsset of random_frame()s, always starting from the same seed.
+ *  @param frame_index true to write a frame index sidecar with the asset.
+ *  @param infos If non-null, filled in with the FrameInfo of each frame that is written.
+ */
+extern std::shared_ptr<dcp::MonoPictureAsset> random_picture_asset (
+	boost::filesystem::path file,
+	int frames,
+	bool frame_index = false,
+	std::vector<dcp::FrameInfo>* infos = nullptr
+	);
 extern boost::filesystem::path find_file (boost::filesystem::path dir, std::string filename_part);
 
 /** Creating an object of this class will make asdcplib's random number generation
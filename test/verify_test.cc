@@ -58,6 +58,7 @@
 #include "verify_j2k.h"
 #include <boost/test/unit_test.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 
@@ -599,6 +600,53 @@ BOOST_AUTO_TEST_CASE (verify_invalid_duration)
 }
 
 
+/* Checking the hash and the frames of picture assets in one pass should give the same notes as doing them separately */
+BOOST_AUTO_TEST_CASE (verify_single_pass)
+{
+	dcp::VerificationOptions options;
+	options.single_pass = true;
+
+	auto dir = setup (3, "verify_single_pass");
+	BOOST_CHECK (dcp::verify({dir}, &stage, &progress, xsd_test) == dcp::verify({dir}, &stage, &progress, xsd_test, options));
+
+	/* Break a picture asset's hash */
+	dir = setup (1, "verify_single_pass_bad_hash");
+	auto video_path = dir / "video.mxf";
+	auto mod = fopen (video_path.string().c_str(), "r+b");
+	BOOST_REQUIRE (mod);
+	fseek (mod, 4096, SEEK_SET);
+	int x = 42;
+	fwrite (&x, sizeof(x), 1, mod);
+	fclose (mod);
+
+	dcp::ASDCPErrorSuspender sus;
+	auto const two_pass = dcp::verify ({dir}, &stage, &progress, xsd_test);
+	BOOST_CHECK (two_pass == dcp::verify({dir}, &stage, &progress, xsd_test, options));
+	BOOST_CHECK (std::find_if(two_pass.begin(), two_pass.end(), [](dcp::VerificationNote const& n) {
+		return n.code() == dcp::VerificationNote::Code::INCORRECT_PICTURE_HASH;
+	}) != two_pass.end());
+}
+
+
+/* Checking picture frames with several threads should give the same notes, in the same order, as with one */
+BOOST_AUTO_TEST_CASE (verify_with_threads)
+{
+	auto dir = setup (3, "verify_with_threads");
+
+	vector<float> single_progress;
+	auto single = dcp::verify ({dir}, &stage, [&single_progress](float p) { single_progress.push_back(p); }, xsd_test);
+
+	for (auto threads: { 2, 4, 16 }) {
+		dcp::VerificationOptions options;
+		options.threads = threads;
+		vector<float> multi_progress;
+		auto multi = dcp::verify ({dir}, &stage, [&multi_progress](float p) { multi_progress.push_back(p); }, xsd_test, options);
+		BOOST_CHECK (single == multi);
+		BOOST_CHECK (single_progress == multi_progress);
+	}
+}
+
+
 static
 shared_ptr<dcp::CPL>
 dcp_from_frame (dcp::ArrayData const& frame, path dir)
@@ -3087,6 +3135,30 @@ BOOST_AUTO_TEST_CASE (verify_jpeg2000_codestream_libdcp)
 }
 
 
+/** Check that a wrong tile-part length in a SOT marker does not stop verify_j2k from finding the next marker */
+BOOST_AUTO_TEST_CASE (verify_jpeg2000_codestream_bad_tile_part_length)
+{
+	boost::filesystem::path dir = "build/test/verify_jpeg2000_codestream_bad_tile_part_length";
+	prepare_directory (dir);
+	auto dcp = make_simple (dir);
+	dcp->write_xml ();
+	dcp::MonoPictureAsset picture (find_file(dir, "video"));
+	auto reader = picture.start_read ();
+	auto original = reader->get_frame (0);
+
+	auto frame = make_shared<dcp::ArrayData>(original->data(), original->size());
+	uint8_t const sot[] = { 0xff, 0x90, 0x00, 0x0a };
+	auto i = std::search (frame->data(), frame->data() + frame->size(), sot, sot + sizeof(sot));
+	BOOST_REQUIRE (i != frame->data() + frame->size());
+	/* Psot is 6 bytes after the start of the marker */
+	i[9]++;
+
+	vector<dcp::VerificationNote> notes;
+	verify_j2k (frame, notes);
+	BOOST_REQUIRE_EQUAL (notes.size(), 0U);
+}
+
+
 /** Check that ResourceID and the XML ID being different is spotted */
 BOOST_AUTO_TEST_CASE (verify_mismatched_subtitle_resource_id)
 {
@@ -77,6 +77,7 @@ void copy (T const& in, shared_ptr<U> writer, bool ignore_hmac)
 {
 	auto reader = in.start_read();
 	reader->set_check_hmac (!ignore_hmac);
+	reader->set_prefetch (4);
 	for (int64_t i = 0; i < in.intrinsic_duration(); ++i) {
 		auto frame = reader->get_frame (i);
 		writer->write (frame->data(), frame->size());
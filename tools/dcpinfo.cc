@@ -33,6 +33,7 @@
 
 #include "dcp.h"
 #include "exceptions.h"
+#include "frame_index.h"
 #include "reel.h"
 #include "sound_asset.h"
 #include "picture_asset.h"
@@ -157,8 +158,20 @@ main_picture (vector<string> const& only, shared_ptr<Reel> reel, bool analyse, b
 		}
 
 		auto ma = dynamic_pointer_cast<MonoPictureAsset>(mp->asset());
-		if (analyse && ma) {
+		auto index = ma ? ma->frame_index() : shared_ptr<const dcp::FrameIndex>();
+		if (analyse && ma && index && index->size() == ma->intrinsic_duration() && !frame_detail && !decompress) {
+			/* We have all we need in the index, so there is no need to read the frames */
+			if (SHOULD_PICTURE) {
+				printf(
+						"      Minimum frame size: %5.1f MBit/s (%6d)\n"
+						"      Maximum frame size: %5.1f MBit/s (%6d)\n",
+						mbits_per_second(static_cast<int>(index->min_essence_size()), ma->frame_rate()), static_cast<int>(index->min_essence_size()),
+						mbits_per_second(static_cast<int>(index->max_essence_size()), ma->frame_rate()), static_cast<int>(index->max_essence_size())
+				      );
+			}
+		} else if (analyse && ma) {
 			auto reader = ma->start_read ();
+			reader->set_prefetch (4);
 			pair<int, int> j2k_size_range (INT_MAX, 0);
 			for (int64_t i = 0; i < ma->intrinsic_duration(); ++i) {
 				auto frame = reader->get_frame (i);
@@ -57,7 +57,10 @@ help (string n)
 	     << "  -h, --help              show this help\n"
 	     << "  --ignore-missing-assets don't give errors about missing assets\n"
 	     << "  --ignore-bv21-smpte     don't give the SMPTE Bv2.1 error about a DCP not being SMPTE\n"
-	     << "  -q, --quiet             don't report progress\n";
+	     << "  -q, --quiet             don't report progress\n"
+	     << "  -j, --threads <n>       number of threads to use when opening assets, checking picture frames and hashing assets\n"
+	     << "  --single-pass           read each picture asset once to check both its hash and its frames\n"
+	     << "  --map                   memory-map picture assets which have frame indexes (unsafe on damaged or changing files)\n";
 }
 
 void
@@ -88,6 +91,7 @@ main (int argc, char* argv[])
 	bool ignore_missing_assets = false;
 	bool ignore_bv21_smpte = false;
 	bool quiet = false;
+	dcp::VerificationOptions verification_options;
 
 	int option_index = 0;
 	while (true) {
@@ -97,10 +101,13 @@ main (int argc, char* argv[])
 			{ "ignore-missing-assets", no_argument, 0, 'A' },
 			{ "ignore-bv21-smpte", no_argument, 0, 'B' },
 			{ "quiet", no_argument, 0, 'q' },
+			{ "threads", required_argument, 0, 'j' },
+			{ "single-pass", no_argument, 0, 'S' },
+			{ "map", no_argument, 0, 'M' },
 			{ 0, 0, 0, 0 }
 		};
 
-		int c = getopt_long (argc, argv, "VhABq", long_options, &option_index);
+		int c = getopt_long (argc, argv, "VhABqj:", long_options, &option_index);
 
 		if (c == -1) {
 			break;
@@ -122,6 +129,20 @@ main (int argc, char* argv[])
 		case 'q':
 			quiet = true;
 			break;
+		case 'j':
+			verification_options.threads = atoi (optarg);
+			if (verification_options.threads < 1) {
+				cerr << argv[0] << ": thread count must be at least 1.\n";
+				exit (EXIT_FAILURE);
+			}
+			verification_options.hash_threads = verification_options.threads;
+			break;
+		case 'S':
+			verification_options.single_pass = true;
+			break;
+		case 'M':
+			verification_options.map_picture_assets = true;
+			break;
 		}
 	}
 
@@ -137,7 +158,7 @@ main (int argc, char* argv[])
 
 	vector<boost::filesystem::path> directories;
 	directories.push_back (argv[optind]);
-	auto notes = dcp::verify (directories, bind(&stage, quiet, _1, _2), bind(&progress));
+	auto notes = dcp::verify (directories, bind(&stage, quiet, _1, _2), bind(&progress), boost::none, verification_options);
 	dcp::filter_notes (notes, ignore_missing_assets);
 
 	bool failed = false;